@@ -5,436 +5,5996 @@
 #include <iomanip>
 #include <stdexcept>
 #include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <random>
+#include <future>
+#include <thread>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <array>
+#include <concepts>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <utility>
 
-struct BigInt
-{
-    // Internal representation: least significant digit first
-    std::vector<uint32_t> digits; // base 2^32
-    bool negative;
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__)) && !defined(BIGINT_NO_SIMD)
+#define BIGINT_X86_SIMD 1
+#include <immintrin.h>
+#endif
 
-    // Constructors
-    BigInt() : negative(false) {}
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(BIGINT_NO_MMAP)
+#define BIGINT_MMAP 1
+#include <fstream>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
-    BigInt(const std::string &s)
+// Raw limb kernels: operate on little-endian uint32_t arrays owned by the caller
+namespace limb_ops
+{
+    // Runtime CPU feature detection, evaluated once per process
+#ifdef BIGINT_X86_SIMD
+    inline bool cpu_has_avx2()
     {
-        negative = false;
-        std::string str = s;
-        if (str[0] == '-')
-        {
-            negative = true;
-            str = str.substr(1);
-        }
+        static const bool has = __builtin_cpu_supports("avx2");
+        return has;
+    }
 
-        // Remove leading zeros
-        while (str.size() > 1 && str[0] == '0')
-            str.erase(0, 1);
+    inline bool cpu_has_avx512()
+    {
+        static const bool has = __builtin_cpu_supports("avx512f");
+        return has;
+    }
 
-        digits.clear();
-        BigInt result(0);
-        for (char c : str)
-        {
-            result = result * 10 + BigInt(c - '0');
-        }
-        digits = result.digits;
+    inline bool cpu_has_ifma()
+    {
+        static const bool has = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512ifma");
+        return has;
     }
 
-    BigInt(int value)
+    inline bool cpu_has_avx512_popcnt()
     {
-        if (value < 0)
-        {
-            negative = true;
-            value = -value;
-        }
-        else
-        {
-            negative = false;
-        }
-        if (value != 0)
-            digits.push_back(static_cast<uint32_t>(value));
+        static const bool has = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq");
+        return has;
     }
 
-    BigInt(uint32_t value) : negative(false)
+    inline bool cpu_has_bmi2()
     {
-        if (value != 0)
-            digits.push_back(value);
+        static const bool has = __builtin_cpu_supports("bmi2");
+        return has;
+    }
+#else
+    inline bool cpu_has_avx2()
+    {
+        return false;
     }
 
-    BigInt(int64_t value)
+    inline bool cpu_has_avx512()
     {
-        if (value < 0)
-        {
-            negative = true;
-            value = -value;
-        }
-        else
-        {
-            negative = false;
-        }
-        if (value != 0)
-        {
-            digits.push_back(static_cast<uint32_t>(value & 0xFFFFFFFF));
-            if (value > 0xFFFFFFFF)
-                digits.push_back(static_cast<uint32_t>((value >> 32) & 0xFFFFFFFF));
-        }
+        return false;
     }
 
-    // Helper functions
-    void trim()
+    inline bool cpu_has_ifma()
     {
-        while (digits.size() > 1 && digits.back() == 0)
-            digits.pop_back();
-        if (digits.size() == 1 && digits[0] == 0)
-            negative = false;
+        return false;
     }
 
-    bool isZero() const
+    inline bool cpu_has_avx512_popcnt()
     {
-        return digits.empty() || (digits.size() == 1 && digits[0] == 0);
+        return false;
     }
 
-    BigInt abs() const
+    inline bool cpu_has_bmi2()
     {
-        BigInt result = *this;
-        result.negative = false;
-        return result;
+        return false;
     }
+#endif
 
-    // Addition
-    BigInt operator+(const BigInt &other) const
+    // Operand sizes (in 32-bit limbs) for which the IFMA kernel replaces schoolbook;
+    // below the lower bound the radix conversion costs more than it saves
+    constexpr size_t IFMA_MUL_MIN_LIMBS = 12;
+    constexpr size_t IFMA_MUL_MAX_LIMBS = 64;
+
+    // Schoolbook multiplication, r must hold an + bn limbs and may not alias a or b
+    inline void mul_basecase(uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn)
     {
-        if (negative == other.negative)
+        std::fill(r, r + an + bn, 0u);
+        for (size_t i = 0; i < an; ++i)
         {
-            BigInt result;
-            result.negative = negative;
             uint64_t carry = 0;
-            size_t n = std::max(digits.size(), other.digits.size());
-            for (size_t i = 0; i < n || carry; ++i)
-            {
-                uint64_t sum = carry;
-                if (i < digits.size())
-                    sum += digits[i];
-                if (i < other.digits.size())
-                    sum += other.digits[i];
-                result.digits.push_back(static_cast<uint32_t>(sum & 0xFFFFFFFF));
+            uint64_t ai = a[i];
+            for (size_t j = 0; j < bn; ++j)
+            {
+                uint64_t sum = r[i + j] + ai * b[j] + carry;
+                r[i + j] = static_cast<uint32_t>(sum);
                 carry = sum >> 32;
             }
-            return result;
+            r[i + bn] = static_cast<uint32_t>(carry);
         }
-        else
+    }
+
+    // Schoolbook squaring: cross products once, doubled, plus the diagonal
+    inline void sqr_basecase(uint32_t *r, const uint32_t *a, size_t n)
+    {
+        std::fill(r, r + 2 * n, 0u);
+        for (size_t i = 0; i + 1 < n; ++i)
+        {
+            uint64_t carry = 0;
+            uint64_t ai = a[i];
+            for (size_t j = i + 1; j < n; ++j)
+            {
+                uint64_t sum = r[i + j] + ai * a[j] + carry;
+                r[i + j] = static_cast<uint32_t>(sum);
+                carry = sum >> 32;
+            }
+            r[i + n] = static_cast<uint32_t>(carry);
+        }
+        uint32_t top = 0;
+        for (size_t i = 0; i < 2 * n; ++i)
+        {
+            uint32_t next = r[i] >> 31;
+            r[i] = (r[i] << 1) | top;
+            top = next;
+        }
+        uint64_t carry = 0;
+        for (size_t i = 0; i < n; ++i)
         {
-            return *this - (-other);
+            uint64_t sq = uint64_t(a[i]) * a[i];
+            uint64_t lo = uint64_t(r[2 * i]) + static_cast<uint32_t>(sq) + carry;
+            r[2 * i] = static_cast<uint32_t>(lo);
+            uint64_t hi = uint64_t(r[2 * i + 1]) + (sq >> 32) + (lo >> 32);
+            r[2 * i + 1] = static_cast<uint32_t>(hi);
+            carry = hi >> 32;
         }
     }
 
-    // Unary minus
-    BigInt operator-() const
+#ifdef BIGINT_X86_SIMD
+    constexpr uint64_t RADIX52_MASK = (uint64_t(1) << 52) - 1;
+    // 64 limbs of 32 bits fit in 40 limbs of 52 bits; round up to whole vectors
+    constexpr size_t IFMA_MAX_LIMBS52 = 40;
+    constexpr size_t IFMA_PAD = 8;
+
+    inline size_t radix52_size(size_t n32)
     {
-        BigInt result = *this;
-        if (!isZero())
-            result.negative = !negative;
-        return result;
+        return (32 * n32 + 51) / 52;
     }
 
-    // Subtraction
-    BigInt operator-(const BigInt &other) const
+    // Repack n32 limbs of 2^32 into radix 2^52, returns the number of 52-bit limbs
+    inline size_t to_radix52(uint64_t *out, const uint32_t *in, size_t n32)
     {
-        if (negative != other.negative)
+        auto limb = [&](size_t w) -> uint64_t { return w < n32 ? in[w] : 0; };
+        size_t n52 = radix52_size(n32);
+        for (size_t k = 0; k < n52; ++k)
         {
-            return *this + (-other);
+            size_t bit = 52 * k;
+            size_t w = bit / 32;
+            unsigned sh = bit % 32;
+            uint64_t v = (limb(w) | (limb(w + 1) << 32)) >> sh;
+            if (sh > 12)
+                v |= limb(w + 2) << (64 - sh);
+            out[k] = v & RADIX52_MASK;
         }
-        else
+        return n52;
+    }
+
+    // Unpack n32 limbs of 2^32 from a normalized radix-2^52 array (one zero limb of slack required)
+    inline void from_radix52(uint32_t *out, size_t n32, const uint64_t *in)
+    {
+        for (size_t i = 0; i < n32; ++i)
         {
-            if (abs() >= other.abs())
-            {
-                BigInt result;
-                result.negative = negative;
-                int64_t borrow = 0;
-                for (size_t i = 0; i < digits.size(); ++i)
-                {
-                    int64_t diff = static_cast<int64_t>(digits[i]) - borrow;
-                    if (i < other.digits.size())
-                        diff -= other.digits[i];
-                    if (diff < 0)
-                    {
-                        diff += (1ULL << 32);
-                        borrow = 1;
-                    }
-                    else
-                    {
-                        borrow = 0;
-                    }
-                    result.digits.push_back(static_cast<uint32_t>(diff & 0xFFFFFFFF));
-                }
-                result.trim();
-                return result;
-            }
-            else
+            size_t bit = 32 * i;
+            size_t w = bit / 52;
+            unsigned sh = bit % 52;
+            uint64_t v = (in[w] >> sh) | (in[w + 1] << (52 - sh));
+            out[i] = static_cast<uint32_t>(v);
+        }
+    }
+
+    // Resolve column sums col[k] = lo[k] + hi[k - 1] into normalized 52-bit limbs
+    inline void radix52_normalize(uint64_t *r52, const uint64_t *lo, const uint64_t *hi, size_t cols)
+    {
+        uint64_t carry = 0;
+        for (size_t k = 0; k < cols; ++k)
+        {
+            uint64_t v = lo[k] + (k ? hi[k - 1] : 0) + carry;
+            r52[k] = v & RADIX52_MASK;
+            carry = v >> 52;
+        }
+        r52[cols] = carry;
+    }
+
+    // Product scanning over radix-2^52 lanes: each 8-column block keeps its low and
+    // high halves in registers while rows of a are broadcast against a sliding window of b
+    __attribute__((target("avx512f,avx512ifma"))) inline void mul_ifma(uint32_t *r, const uint32_t *a, size_t an,
+                                                                        const uint32_t *b, size_t bn)
+    {
+        alignas(64) uint64_t a52[IFMA_MAX_LIMBS52];
+        alignas(64) uint64_t bpad[IFMA_PAD + IFMA_MAX_LIMBS52 + IFMA_PAD];
+        alignas(64) uint64_t lo[2 * IFMA_MAX_LIMBS52 + IFMA_PAD];
+        alignas(64) uint64_t hi[2 * IFMA_MAX_LIMBS52 + IFMA_PAD];
+        uint64_t r52[2 * IFMA_MAX_LIMBS52 + 1];
+
+        size_t na = to_radix52(a52, a, an);
+        size_t nb = to_radix52(bpad + IFMA_PAD, b, bn);
+        std::fill(bpad, bpad + IFMA_PAD, 0);
+        std::fill(bpad + IFMA_PAD + nb, bpad + 2 * IFMA_PAD + nb, 0);
+        size_t cols = na + nb;
+        const uint64_t *bz = bpad + IFMA_PAD;
+
+        for (size_t k = 0; k < cols; k += 8)
+        {
+            __m512i acc_lo = _mm512_setzero_si512();
+            __m512i acc_hi = _mm512_setzero_si512();
+            // Rows contributing to columns k..k+7 satisfy k - nb < i <= k + 7
+            size_t i_begin = k + 1 > nb ? k + 1 - nb : 0;
+            size_t i_end = std::min(na, k + 8);
+            for (size_t i = i_begin; i < i_end; ++i)
             {
-                return -(other - *this);
+                __m512i ai = _mm512_set1_epi64(static_cast<long long>(a52[i]));
+                __m512i bj = _mm512_loadu_si512(bz + k - i);
+                acc_lo = _mm512_madd52lo_epu64(acc_lo, ai, bj);
+                acc_hi = _mm512_madd52hi_epu64(acc_hi, ai, bj);
             }
+            _mm512_store_si512(lo + k, acc_lo);
+            _mm512_store_si512(hi + k, acc_hi);
         }
+
+        radix52_normalize(r52, lo, hi, cols);
+        from_radix52(r, an + bn, r52);
     }
 
-    // Multiplication
-    BigInt operator*(const BigInt &other) const
+    // Squaring variant: only the pairs i < j are accumulated (masked per lane), then the
+    // columns are doubled and the diagonal squares added
+    __attribute__((target("avx512f,avx512ifma"))) inline void sqr_ifma(uint32_t *r, const uint32_t *a, size_t n)
     {
-        BigInt result;
-        result.digits.resize(digits.size() + other.digits.size());
-        result.negative = negative != other.negative;
-        for (size_t i = 0; i < digits.size(); ++i)
+        alignas(64) uint64_t apad[IFMA_PAD + IFMA_MAX_LIMBS52 + IFMA_PAD];
+        alignas(64) uint64_t lo[2 * IFMA_MAX_LIMBS52 + IFMA_PAD];
+        alignas(64) uint64_t hi[2 * IFMA_MAX_LIMBS52 + IFMA_PAD];
+        uint64_t r52[2 * IFMA_MAX_LIMBS52 + 1];
+
+        size_t na = to_radix52(apad + IFMA_PAD, a, n);
+        std::fill(apad, apad + IFMA_PAD, 0);
+        std::fill(apad + IFMA_PAD + na, apad + 2 * IFMA_PAD + na, 0);
+        size_t cols = 2 * na;
+        const uint64_t *az = apad + IFMA_PAD;
+
+        for (size_t k = 0; k < cols; k += 8)
         {
-            uint64_t carry = 0;
-            for (size_t j = 0; j < other.digits.size() || carry; ++j)
+            __m512i acc_lo = _mm512_setzero_si512();
+            __m512i acc_hi = _mm512_setzero_si512();
+            size_t i_begin = k + 1 > na ? k + 1 - na : 0;
+            // Lane t (column k + t) takes row i only while i < k + t - i
+            for (size_t i = i_begin; i < na && 2 * i < k + 7; ++i)
             {
-                uint64_t sum = result.digits[i + j] +
-                               digits[i] * 1ULL * (j < other.digits.size() ? other.digits[j] : 0) + carry;
-                result.digits[i + j] = static_cast<uint32_t>(sum & 0xFFFFFFFF);
-                carry = sum >> 32;
+                unsigned first = 2 * i + 1 > k ? static_cast<unsigned>(2 * i + 1 - k) : 0;
+                __mmask8 m = static_cast<__mmask8>(0xFFu << first);
+                __m512i ai = _mm512_set1_epi64(static_cast<long long>(az[i]));
+                __m512i aj = _mm512_loadu_si512(az + k - i);
+                acc_lo = _mm512_mask_madd52lo_epu64(acc_lo, m, ai, aj);
+                acc_hi = _mm512_mask_madd52hi_epu64(acc_hi, m, ai, aj);
             }
+            _mm512_store_si512(lo + k, _mm512_add_epi64(acc_lo, acc_lo));
+            _mm512_store_si512(hi + k, _mm512_add_epi64(acc_hi, acc_hi));
         }
-        result.trim();
-        return result;
+        for (size_t i = 0; i < na; ++i)
+        {
+            unsigned __int128 sq = static_cast<unsigned __int128>(az[i]) * az[i];
+            lo[2 * i] += static_cast<uint64_t>(sq) & RADIX52_MASK;
+            hi[2 * i] += static_cast<uint64_t>(sq >> 52);
+        }
+
+        radix52_normalize(r52, lo, hi, cols);
+        from_radix52(r, 2 * n, r52);
     }
+#endif
 
-    // Division and Modulo
-    BigInt operator/(const BigInt &other) const
+    inline bool ifma_eligible(size_t n)
     {
-        BigInt quotient, remainder;
-        divmod(*this, other, quotient, remainder);
-        return quotient;
+        return n >= IFMA_MUL_MIN_LIMBS && n <= IFMA_MUL_MAX_LIMBS;
     }
 
-    BigInt operator%(const BigInt &other) const
+    // Base-case dispatch: IFMA inside its window, schoolbook otherwise
+    inline void mul_base(uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn)
     {
-        BigInt quotient, remainder;
-        divmod(*this, other, quotient, remainder);
-        return remainder;
+#ifdef BIGINT_X86_SIMD
+        if (ifma_eligible(an) && ifma_eligible(bn) && cpu_has_ifma())
+        {
+            mul_ifma(r, a, an, b, bn);
+            return;
+        }
+#endif
+        mul_basecase(r, a, an, b, bn);
     }
 
-    // Bitwise AND
-    BigInt operator&(const BigInt &other) const
+    inline void sqr_base(uint32_t *r, const uint32_t *a, size_t n)
     {
-        BigInt result;
-        size_t n = std::min(digits.size(), other.digits.size());
-        for (size_t i = 0; i < n; ++i)
+#ifdef BIGINT_X86_SIMD
+        if (ifma_eligible(n) && cpu_has_ifma())
         {
-            result.digits.push_back(digits[i] & other.digits[i]);
+            sqr_ifma(r, a, n);
+            return;
         }
-        result.trim();
-        return result;
+#endif
+        sqr_basecase(r, a, n);
     }
 
-    // Bitwise OR
-    BigInt operator|(const BigInt &other) const
+    // Carry-propagating primitives; r may alias an input at the same offset
+
+    // r[0..n) = a + b, returns the carry
+    inline uint32_t add_n(uint32_t *r, const uint32_t *a, const uint32_t *b, size_t n)
     {
-        BigInt result;
-        size_t n = std::max(digits.size(), other.digits.size());
+        uint64_t carry = 0;
         for (size_t i = 0; i < n; ++i)
         {
-            uint32_t a = i < digits.size() ? digits[i] : 0;
-            uint32_t b = i < other.digits.size() ? other.digits[i] : 0;
-            result.digits.push_back(a | b);
+            carry += uint64_t(a[i]) + b[i];
+            r[i] = static_cast<uint32_t>(carry);
+            carry >>= 32;
         }
-        result.trim();
-        return result;
+        return static_cast<uint32_t>(carry);
     }
 
-    // Input and Output
-    friend std::istream &operator>>(std::istream &is, BigInt &bigint)
+    // r[0..n) = a - b, returns the borrow
+    inline uint32_t sub_n(uint32_t *r, const uint32_t *a, const uint32_t *b, size_t n)
     {
-        std::string s;
-        is >> s;
-        bigint = BigInt(s);
-        return is;
+        uint64_t borrow = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            uint64_t d = uint64_t(a[i]) - b[i] - borrow;
+            r[i] = static_cast<uint32_t>(d);
+            borrow = (d >> 32) & 1;
+        }
+        return static_cast<uint32_t>(borrow);
     }
 
-    friend std::ostream &operator<<(std::ostream &os, const BigInt &bigint)
+    // r[0..n) = a + c, returns the carry
+    inline uint32_t add_1(uint32_t *r, const uint32_t *a, size_t n, uint32_t c)
     {
-        if (bigint.isZero())
+        for (size_t i = 0; i < n; ++i)
         {
-            os << '0';
-            return os;
+            uint64_t sum = uint64_t(a[i]) + c;
+            r[i] = static_cast<uint32_t>(sum);
+            c = static_cast<uint32_t>(sum >> 32);
+            if (c == 0 && r == a)
+                return 0;
         }
-        if (bigint.negative)
-            os << '-';
+        return c;
+    }
 
-        // Convert digits to base 10
-        BigInt temp = bigint.abs();
-        std::string s;
-        while (!temp.isZero())
+    // r[0..n) = a - c, returns the borrow
+    inline uint32_t sub_1(uint32_t *r, const uint32_t *a, size_t n, uint32_t c)
+    {
+        for (size_t i = 0; i < n; ++i)
         {
-            uint32_t remainder = temp.divmod_small(10);
-            s.push_back(static_cast<char>('0' + remainder));
+            uint32_t ai = a[i];
+            r[i] = ai - c;
+            c = ai < c ? 1 : 0;
+            if (c == 0 && r == a)
+                return 0;
         }
-        std::reverse(s.begin(), s.end());
-        os << s;
-        return os;
+        return c;
     }
 
-    // Shift operators
-    BigInt operator<<(int shift) const
+    // r[0..an) = a + b for an >= bn, returns the carry
+    inline uint32_t add(uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn)
     {
-        if (isZero() || shift == 0)
-            return *this;
-        BigInt result = *this;
-        int word_shift = shift / 32;
-        int bit_shift = shift % 32;
-        uint32_t carry = 0;
-        result.digits.insert(result.digits.begin(), word_shift, 0);
-        for (size_t i = word_shift; i < result.digits.size(); ++i)
-        {
-            uint64_t current = (uint64_t(result.digits[i]) << bit_shift) | carry;
-            result.digits[i] = static_cast<uint32_t>(current & 0xFFFFFFFF);
-            carry = current >> 32;
-        }
-        if (carry)
-            result.digits.push_back(static_cast<uint32_t>(carry));
-        result.trim();
-        return result;
+        uint32_t carry = add_n(r, a, b, bn);
+        return add_1(r + bn, a + bn, an - bn, carry);
     }
 
-    BigInt operator>>(int shift) const
+    // r[0..an) = a - b for an >= bn, returns the borrow
+    inline uint32_t sub(uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn)
     {
-        if (isZero() || shift == 0)
-            return *this;
-        BigInt result = *this;
-        int word_shift = shift / 32;
-        int bit_shift = shift % 32;
-        if (word_shift >= static_cast<int>(result.digits.size()))
+        uint32_t borrow = sub_n(r, a, b, bn);
+        return sub_1(r + bn, a + bn, an - bn, borrow);
+    }
+
+    // r[0..n) = a * m, returns the high limb
+    inline uint32_t mul_1(uint32_t *r, const uint32_t *a, size_t n, uint32_t m)
+    {
+        uint64_t carry = 0;
+        for (size_t i = 0; i < n; ++i)
         {
-            return BigInt(0);
+            carry += uint64_t(a[i]) * m;
+            r[i] = static_cast<uint32_t>(carry);
+            carry >>= 32;
         }
-        result.digits.erase(result.digits.begin(), result.digits.begin() + word_shift);
-        uint32_t carry = 0;
-        for (int i = static_cast<int>(result.digits.size()) - 1; i >= 0; --i)
+        return static_cast<uint32_t>(carry);
+    }
+
+    inline int cmp_n(const uint32_t *a, const uint32_t *b, size_t n)
+    {
+        for (size_t i = n; i-- > 0;)
         {
-            uint64_t current = (uint64_t(carry) << 32) | result.digits[i];
-            result.digits[i] = static_cast<uint32_t>((current >> bit_shift) & 0xFFFFFFFF);
-            carry = static_cast<uint32_t>(current & ((1ULL << bit_shift) - 1));
+            if (a[i] != b[i])
+                return a[i] < b[i] ? -1 : 1;
         }
-        result.trim();
-        return result;
+        return 0;
     }
 
-    // Shift-assignment operators
-    BigInt &operator<<=(int shift)
+    // Per-thread bump allocator for kernel temporaries. Blocks are kept once obtained, so
+    // a kernel run in steady state does no heap work at all. Requests that would grow the
+    // arena past its cap (in limbs) are served from the heap and freed on release.
+    // Memory is handed out uninitialised, in whole 64-byte lines.
+    class ScratchArena
+    {
+    public:
+        struct Mark
+        {
+            size_t block;
+            size_t used;
+            size_t overflow;
+        };
+
+        static constexpr size_t DEFAULT_CAP = size_t(1) << 24; // 64 MiB
+        static constexpr size_t MIN_BLOCK = 4096;
+
+        uint32_t *alloc(size_t n)
+        {
+            n = (std::max<size_t>(n, 1) + 15) & ~size_t(15);
+            for (; block < blocks.size(); ++block, used = 0)
+            {
+                if (used + n <= blocks[block].size)
+                {
+                    uint32_t *p = blocks[block].data.get() + used;
+                    used += n;
+                    return p;
+                }
+            }
+            // Every block from here on is free; grow geometrically while under the cap
+            size_t size = std::max(n, blocks.empty() ? MIN_BLOCK : 2 * blocks.back().size);
+            if (reserved + size > cap_limit)
+                size = n;
+            ++heap_count;
+            if (reserved + size <= cap_limit)
+            {
+                blocks.push_back({std::make_unique_for_overwrite<uint32_t[]>(size), size});
+                reserved += size;
+                used = n;
+                return blocks.back().data.get();
+            }
+            overflow.push_back(std::make_unique_for_overwrite<uint32_t[]>(n));
+            return overflow.back().get();
+        }
+
+        Mark mark() const
+        {
+            return {block, used, overflow.size()};
+        }
+
+        // Frees everything allocated since m; marks must be released in LIFO order
+        void release(const Mark &m)
+        {
+            block = m.block;
+            used = m.used;
+            overflow.resize(m.overflow);
+        }
+
+        // Limbs the arena may hold before falling back to the heap; blocks already
+        // obtained are kept even if the new cap is lower
+        void set_cap(size_t limbs)
+        {
+            cap_limit = limbs;
+        }
+
+        size_t cap() const
+        {
+            return cap_limit;
+        }
+
+        // Heap allocations made on behalf of the arena so far (blocks and overflow)
+        size_t heap_allocations() const
+        {
+            return heap_count;
+        }
+
+    private:
+        struct Block
+        {
+            std::unique_ptr<uint32_t[]> data;
+            size_t size;
+        };
+
+        std::vector<Block> blocks;
+        std::vector<std::unique_ptr<uint32_t[]>> overflow;
+        size_t block = 0;
+        size_t used = 0;
+        size_t reserved = 0;
+        size_t cap_limit = DEFAULT_CAP;
+        size_t heap_count = 0;
+    };
+
+    inline ScratchArena &scratch()
     {
-        return *this = *this << shift;
+        thread_local ScratchArena arena;
+        return arena;
     }
 
-    BigInt &operator>>=(int shift)
+    // Scope on the calling thread's arena: everything allocated through it, or through
+    // scratch() while it is the innermost frame, is released when it goes out of scope
+    class ScratchFrame
+    {
+    public:
+        ScratchFrame() : arena(scratch()), saved(arena.mark()) {}
+        ~ScratchFrame() { arena.release(saved); }
+        ScratchFrame(const ScratchFrame &) = delete;
+        ScratchFrame &operator=(const ScratchFrame &) = delete;
+
+        uint32_t *alloc(size_t n)
+        {
+            return arena.alloc(n);
+        }
+
+    private:
+        ScratchArena &arena;
+        ScratchArena::Mark saved;
+    };
+
+    // Operand size (in limbs) from which Karatsuba beats schoolbook; with IFMA
+    // the base case stays faster across its whole window
+    constexpr size_t KARATSUBA_THRESHOLD = 32;
+
+    inline size_t karatsuba_threshold()
     {
-        return *this = *this >> shift;
+        static const size_t threshold = cpu_has_ifma() ? IFMA_MUL_MAX_LIMBS + 1 : KARATSUBA_THRESHOLD;
+        return threshold;
     }
 
-    // Comparison operators
-    bool operator<(const BigInt &other) const
+    inline void mul_n(uint32_t *r, const uint32_t *a, const uint32_t *b, size_t n);
+    inline void sqr(uint32_t *r, const uint32_t *a, size_t n);
+
+    // r[0..m) = |a[0..m) - b[0..bn)| for m >= bn, returns true when a < b
+    inline bool abs_diff(uint32_t *r, const uint32_t *a, const uint32_t *b, size_t m, size_t bn)
     {
-        if (negative != other.negative)
-            return negative;
-        if (digits.size() != other.digits.size())
-            return negative ? digits.size() > other.digits.size() : digits.size() < other.digits.size();
-        for (int i = static_cast<int>(digits.size()) - 1; i >= 0; --i)
+        bool less = std::all_of(a + bn, a + m, [](uint32_t w) { return w == 0; }) && cmp_n(a, b, bn) < 0;
+        if (less)
         {
-            if (digits[i] != other.digits[i])
-                return negative ? digits[i] > other.digits[i] : digits[i] < other.digits[i];
+            sub_n(r, b, a, bn);
+            std::fill(r + bn, r + m, 0u);
         }
-        return false;
+        else
+        {
+            sub(r, a, m, b, bn);
+        }
+        return less;
     }
 
-    bool operator>=(const BigInt &other) const
+    // Subtractive Karatsuba on n x n limbs, split as a = a1*B^h + a0 with h = n/2:
+    // a*b = z2*B^2h + (z0 + z2 - (a1 - a0)(b1 - b0))*B^h + z0
+    inline void karatsuba(uint32_t *r, const uint32_t *a, const uint32_t *b, size_t n)
     {
-        return !(*this < other);
+        size_t h = n / 2;
+        size_t m = n - h;
+        ScratchFrame frame;
+        uint32_t *da = frame.alloc(2 * m);
+        uint32_t *db = da + m;
+        uint32_t *mid = frame.alloc(2 * m);
+        bool neg = abs_diff(da, a + h, a, m, h) != abs_diff(db, b + h, b, m, h);
+
+        mul_n(r, a, b, h);
+        mul_n(r + 2 * h, a + h, b + h, m);
+        mul_n(mid, da, db, m);
+        // z1 <- z0 + z2 -/+ |a1 - a0||b1 - b0|, at most 2m + 1 limbs
+        uint32_t *z1 = frame.alloc(2 * m + 1);
+        z1[2 * m] = add(z1, r + 2 * h, 2 * m, r, 2 * h);
+        if (neg)
+            z1[2 * m] += add(z1, z1, 2 * m, mid, 2 * m);
+        else
+            z1[2 * m] -= sub(z1, z1, 2 * m, mid, 2 * m);
+        add(r + h, r + h, 2 * n - h, z1, 2 * m + 1);
     }
 
-    // Equality operator
-    bool operator==(const BigInt &other) const
+    inline void karatsuba_sqr(uint32_t *r, const uint32_t *a, size_t n)
     {
-        return negative == other.negative && digits == other.digits;
+        size_t h = n / 2;
+        size_t m = n - h;
+        ScratchFrame frame;
+        uint32_t *da = frame.alloc(m);
+        uint32_t *mid = frame.alloc(2 * m);
+        abs_diff(da, a + h, a, m, h);
+
+        sqr(r, a, h);
+        sqr(r + 2 * h, a + h, m);
+        sqr(mid, da, m);
+        uint32_t *z1 = frame.alloc(2 * m + 1);
+        z1[2 * m] = add(z1, r + 2 * h, 2 * m, r, 2 * h);
+        z1[2 * m] -= sub(z1, z1, 2 * m, mid, 2 * m);
+        add(r + h, r + h, 2 * n - h, z1, 2 * m + 1);
     }
 
-private:
-    // Division by small integer
-    uint32_t divmod_small(uint32_t divisor)
+    // Balanced n x n product into r[0..2n)
+    inline void mul_n(uint32_t *r, const uint32_t *a, const uint32_t *b, size_t n)
     {
-        uint64_t remainder = 0;
-        for (int i = static_cast<int>(digits.size()) - 1; i >= 0; --i)
-        {
-            uint64_t current = (remainder << 32) + digits[i];
-            digits[i] = static_cast<uint32_t>(current / divisor);
-            remainder = current % divisor;
-        }
-        trim();
-        return static_cast<uint32_t>(remainder);
+        if (n < karatsuba_threshold())
+            mul_base(r, a, n, b, n);
+        else
+            karatsuba(r, a, b, n);
     }
 
-    // Division and Modulo
-    static void divmod(const BigInt &a, const BigInt &b, BigInt &quotient, BigInt &remainder)
+    // Multiplication dispatch, r must hold an + bn limbs and may not alias a or b.
+    // Unbalanced operands are cut into bn-sized slices of the longer one.
+    inline void mul(uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn)
     {
-        if (b.isZero())
+        if (an < bn)
         {
-            throw std::runtime_error("Division by zero");
+            std::swap(a, b);
+            std::swap(an, bn);
         }
-        if (a.isZero())
+        if (bn < karatsuba_threshold())
         {
-            quotient = BigInt(0);
-            remainder = BigInt(0);
+            mul_base(r, a, an, b, bn);
             return;
         }
-        quotient = BigInt(0);
-        remainder = a.abs();
-        BigInt divisor = b.abs();
-        if (remainder < divisor)
+        if (an == bn)
         {
-            quotient = BigInt(0);
-            remainder = a;
+            karatsuba(r, a, b, an);
             return;
         }
-        int norm = 32 - __builtin_clz(divisor.digits.back());
-        if (norm != 0)
+        std::fill(r, r + an + bn, 0u);
+        ScratchFrame frame;
+        uint32_t *tmp = frame.alloc(2 * bn);
+        size_t i = 0;
+        for (; i + bn <= an; i += bn)
+        {
+            mul_n(tmp, a + i, b, bn);
+            add(r + i, r + i, an + bn - i, tmp, 2 * bn);
+        }
+        if (i < an)
         {
-            divisor <<= norm;
-            remainder <<= norm;
+            mul(tmp, b, bn, a + i, an - i);
+            add(r + i, r + i, an + bn - i, tmp, bn + an - i);
         }
+    }
 
-        size_t n = remainder.digits.size();
-        size_t m = divisor.digits.size();
+    inline void sqr(uint32_t *r, const uint32_t *a, size_t n)
+    {
+        if (n < karatsuba_threshold())
+            sqr_base(r, a, n);
+        else
+            karatsuba_sqr(r, a, n);
+    }
 
-        quotient.digits.resize(n - m + 1);
-        for (int i = static_cast<int>(n - m); i >= 0; --i)
-        {
-            uint64_t r_hi = (i + m < remainder.digits.size()) ? remainder.digits[i + m] : 0;
-            uint64_t r_lo = remainder.digits[i + m - 1];
+    // Bitwise kernels over n limbs; r may alias a or b
+    enum BitOp
+    {
+        BIT_AND,
+        BIT_OR,
+        BIT_XOR,
+        BIT_ANDNOT, // a & ~b
+        BIT_NOT     // ~a, b is ignored
+    };
 
-            uint64_t numerator = (r_hi << 32) + r_lo;
-            uint64_t denominator = divisor.digits.back();
-            uint64_t qguess = numerator / denominator;
-            if (qguess > 0xFFFFFFFF)
-                qguess = 0xFFFFFFFF;
+    // Below this many limbs the vector setup is not worth it
+    constexpr size_t SIMD_MIN_LIMBS = 16;
 
-            BigInt mult = divisor * static_cast<uint32_t>(qguess);
-            mult <<= 32 * i;
-            while (remainder < mult)
-            {
-                --qguess;
-                mult = divisor * static_cast<uint32_t>(qguess);
-                mult <<= 32 * i;
-            }
-            quotient.digits[i] = static_cast<uint32_t>(qguess);
-            remainder = remainder - mult;
-        }
-        quotient.trim();
-        if (norm != 0)
-            remainder >>= norm;
-        quotient.negative = a.negative != b.negative;
-        remainder.negative = a.negative;
-        quotient.trim();
-        remainder.trim();
+    template <BitOp Op>
+    inline uint32_t bitop_word(uint32_t a, uint32_t b)
+    {
+        if constexpr (Op == BIT_AND)
+            return a & b;
+        else if constexpr (Op == BIT_OR)
+            return a | b;
+        else if constexpr (Op == BIT_XOR)
+            return a ^ b;
+        else if constexpr (Op == BIT_ANDNOT)
+            return a & ~b;
+        else
+            return ~a;
     }
-};
 
-int main()
+    template <BitOp Op>
+    inline void bitop_scalar(uint32_t *r, const uint32_t *a, const uint32_t *b, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i)
+            r[i] = bitop_word<Op>(a[i], b[i]);
+    }
+
+#ifdef BIGINT_X86_SIMD
+    template <BitOp Op>
+    __attribute__((target("avx2"))) inline void bitop_avx2(uint32_t *r, const uint32_t *a, const uint32_t *b, size_t n)
+    {
+        const __m256i ones = _mm256_set1_epi32(-1);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+            __m256i v;
+            if constexpr (Op == BIT_AND)
+                v = _mm256_and_si256(va, vb);
+            else if constexpr (Op == BIT_OR)
+                v = _mm256_or_si256(va, vb);
+            else if constexpr (Op == BIT_XOR)
+                v = _mm256_xor_si256(va, vb);
+            else if constexpr (Op == BIT_ANDNOT)
+                v = _mm256_andnot_si256(vb, va);
+            else
+                v = _mm256_xor_si256(va, ones);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i), v);
+        }
+        bitop_scalar<Op>(r + i, a + i, b + i, n - i);
+    }
+
+    template <BitOp Op>
+    __attribute__((target("avx512f"))) inline void bitop_avx512(uint32_t *r, const uint32_t *a, const uint32_t *b, size_t n)
+    {
+        const __m512i ones = _mm512_set1_epi32(-1);
+        for (size_t i = 0; i < n; i += 16)
+        {
+            // Masked loads and stores cover the tail without a scalar loop
+            __mmask16 m = n - i >= 16 ? __mmask16(0xFFFF) : static_cast<__mmask16>((1u << (n - i)) - 1);
+            __m512i va = _mm512_maskz_loadu_epi32(m, a + i);
+            __m512i vb = _mm512_maskz_loadu_epi32(m, b + i);
+            __m512i v;
+            if constexpr (Op == BIT_AND)
+                v = _mm512_and_si512(va, vb);
+            else if constexpr (Op == BIT_OR)
+                v = _mm512_or_si512(va, vb);
+            else if constexpr (Op == BIT_XOR)
+                v = _mm512_xor_si512(va, vb);
+            else if constexpr (Op == BIT_ANDNOT)
+                v = _mm512_andnot_si512(vb, va);
+            else
+                v = _mm512_xor_si512(va, ones);
+            _mm512_mask_storeu_epi32(r + i, m, v);
+        }
+    }
+#endif
+
+    template <BitOp Op>
+    inline void bitop_n(uint32_t *r, const uint32_t *a, const uint32_t *b, size_t n)
+    {
+#ifdef BIGINT_X86_SIMD
+        if (n >= SIMD_MIN_LIMBS)
+        {
+            if (cpu_has_avx512())
+                return bitop_avx512<Op>(r, a, b, n);
+            if (cpu_has_avx2())
+                return bitop_avx2<Op>(r, a, b, n);
+        }
+#endif
+        bitop_scalar<Op>(r, a, b, n);
+    }
+
+    inline void not_n(uint32_t *r, const uint32_t *a, size_t n)
+    {
+        bitop_n<BIT_NOT>(r, a, a, n);
+    }
+
+    // Shift kernels by 0 <= s < 32 bits. Word shifts are applied by the caller through
+    // pointer offsets, so r may alias a or sit above it (lshift) / below it (rshift).
+
+    // Bitwise op under infinite-precision two's complement on sign-magnitude inputs.
+    // Negative operands are complemented (~m + 1) limb by limb as they are read and a
+    // negative result is converted back the same way, so nothing is materialized.
+    // r needs n limbs, where n covers both operands plus one limb for the sign
+    // extension; r may alias a or b. Returns the sign of the result.
+    template <BitOp Op>
+    inline bool bitop_signed(uint32_t *r, size_t n, const uint32_t *a, size_t an, bool aneg,
+                             const uint32_t *b, size_t bn, bool bneg)
+    {
+        const uint32_t amask = aneg ? ~0u : 0u;
+        const uint32_t bmask = bneg ? ~0u : 0u;
+        const bool rneg = bitop_word<Op>(amask, bmask) != 0;
+        const uint32_t rmask = rneg ? ~0u : 0u;
+        uint64_t ca = aneg, cb = bneg, cr = rneg;
+        for (size_t i = 0; i < n; ++i)
+        {
+            uint64_t x = uint64_t((i < an ? a[i] : 0u) ^ amask) + ca;
+            uint64_t y = uint64_t((i < bn ? b[i] : 0u) ^ bmask) + cb;
+            ca = x >> 32;
+            cb = y >> 32;
+            uint32_t z = bitop_word<Op>(static_cast<uint32_t>(x), static_cast<uint32_t>(y));
+            uint64_t m = uint64_t(z ^ rmask) + cr;
+            cr = m >> 32;
+            r[i] = static_cast<uint32_t>(m);
+        }
+        return rneg;
+    }
+
+    // Population count of a[0..n), or of a ^ b when Xor is set
+    template <bool Xor>
+    inline uint64_t popcount_scalar(const uint32_t *a, const uint32_t *b, size_t n)
+    {
+        uint64_t count = 0;
+        for (size_t i = 0; i < n; ++i)
+            count += __builtin_popcount(Xor ? a[i] ^ b[i] : a[i]);
+        return count;
+    }
+
+#ifdef BIGINT_X86_SIMD
+    // Nibble lookup through pshufb, byte counts folded into 64-bit lanes with psadbw
+    template <bool Xor>
+    __attribute__((target("avx2,popcnt"))) inline uint64_t popcount_avx2(const uint32_t *a, const uint32_t *b, size_t n)
+    {
+        const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                             0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i low4 = _mm256_set1_epi8(0x0F);
+        __m256i acc = _mm256_setzero_si256();
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            if (Xor)
+                v = _mm256_xor_si256(v, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i)));
+            __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, low4));
+            __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low4));
+            acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
+        }
+        uint64_t count = static_cast<uint64_t>(_mm256_extract_epi64(acc, 0)) + static_cast<uint64_t>(_mm256_extract_epi64(acc, 1)) +
+                         static_cast<uint64_t>(_mm256_extract_epi64(acc, 2)) + static_cast<uint64_t>(_mm256_extract_epi64(acc, 3));
+        return count + popcount_scalar<Xor>(a + i, b + i, n - i);
+    }
+
+    template <bool Xor>
+    __attribute__((target("avx512f,avx512vpopcntdq"))) inline uint64_t popcount_avx512(const uint32_t *a, const uint32_t *b, size_t n)
+    {
+        __m512i acc = _mm512_setzero_si512();
+        for (size_t i = 0; i < n; i += 16)
+        {
+            __mmask16 m = n - i >= 16 ? __mmask16(0xFFFF) : static_cast<__mmask16>((1u << (n - i)) - 1);
+            __m512i v = _mm512_maskz_loadu_epi32(m, a + i);
+            if (Xor)
+                v = _mm512_xor_si512(v, _mm512_maskz_loadu_epi32(m, b + i));
+            acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(v));
+        }
+        return static_cast<uint64_t>(_mm512_reduce_add_epi64(acc));
+    }
+#endif
+
+    template <bool Xor>
+    inline uint64_t popcount_dispatch(const uint32_t *a, const uint32_t *b, size_t n)
+    {
+#ifdef BIGINT_X86_SIMD
+        if (n >= SIMD_MIN_LIMBS)
+        {
+            if (cpu_has_avx512_popcnt())
+                return popcount_avx512<Xor>(a, b, n);
+            if (cpu_has_avx2())
+                return popcount_avx2<Xor>(a, b, n);
+        }
+#endif
+        return popcount_scalar<Xor>(a, b, n);
+    }
+
+    inline uint64_t popcount(const uint32_t *a, size_t n)
+    {
+        return popcount_dispatch<false>(a, a, n);
+    }
+
+    // popcount(a ^ b) over n limbs
+    inline uint64_t hamming(const uint32_t *a, const uint32_t *b, size_t n)
+    {
+        return popcount_dispatch<true>(a, b, n);
+    }
+
+    // Index of the lowest set bit at or above bit `from`, or n * 32 when there is none
+    inline size_t scan1(const uint32_t *a, size_t n, size_t from)
+    {
+        size_t i = from / 32;
+        if (i >= n)
+            return n * 32;
+        uint32_t w = a[i] & (~0u << (from % 32));
+        while (w == 0)
+        {
+            if (++i == n)
+                return n * 32;
+            w = a[i];
+        }
+        return i * 32 + __builtin_ctz(w);
+    }
+
+    // Index of the lowest clear bit at or above bit `from`; bits past the end read as zero
+    inline size_t scan0(const uint32_t *a, size_t n, size_t from)
+    {
+        size_t i = from / 32;
+        if (i >= n)
+            return from;
+        uint32_t w = ~a[i] & (~0u << (from % 32));
+        while (w == 0)
+        {
+            if (++i == n)
+                return n * 32;
+            w = ~a[i];
+        }
+        return i * 32 + __builtin_ctz(w);
+    }
+
+    // r[0..n) = a[0..n) << s, returns the bits shifted out of the top limb
+    inline uint32_t lshift_scalar(uint32_t *r, const uint32_t *a, size_t n, unsigned s)
+    {
+        uint32_t out = a[n - 1] >> (32 - s);
+        for (size_t i = n - 1; i > 0; --i)
+            r[i] = (a[i] << s) | (a[i - 1] >> (32 - s));
+        r[0] = a[0] << s;
+        return out;
+    }
+
+    // r[0..n) = a[0..n) >> s, returns the bits shifted out of the bottom limb (in the high end)
+    inline uint32_t rshift_scalar(uint32_t *r, const uint32_t *a, size_t n, unsigned s)
+    {
+        uint32_t out = a[0] << (32 - s);
+        for (size_t i = 0; i + 1 < n; ++i)
+            r[i] = (a[i] >> s) | (a[i + 1] << (32 - s));
+        r[n - 1] = a[n - 1] >> s;
+        return out;
+    }
+
+#ifdef BIGINT_X86_SIMD
+    // Walk from the top so every block is read before anything below it is written
+    __attribute__((target("avx2"))) inline uint32_t lshift_avx2(uint32_t *r, const uint32_t *a, size_t n, unsigned s)
+    {
+        uint32_t out = a[n - 1] >> (32 - s);
+        const __m128i cl = _mm_cvtsi32_si128(static_cast<int>(s));
+        const __m128i cr = _mm_cvtsi32_si128(static_cast<int>(32 - s));
+        size_t i = n;
+        while (i >= 9)
+        {
+            i -= 8;
+            __m256i cur = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            __m256i prev = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i - 1));
+            __m256i v = _mm256_or_si256(_mm256_sll_epi32(cur, cl), _mm256_srl_epi32(prev, cr));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i), v);
+        }
+        lshift_scalar(r, a, i, s);
+        return out;
+    }
+
+    __attribute__((target("avx512f"))) inline uint32_t lshift_avx512(uint32_t *r, const uint32_t *a, size_t n, unsigned s)
+    {
+        uint32_t out = a[n - 1] >> (32 - s);
+        const __m128i cl = _mm_cvtsi32_si128(static_cast<int>(s));
+        const __m128i cr = _mm_cvtsi32_si128(static_cast<int>(32 - s));
+        size_t i = n;
+        while (i >= 17)
+        {
+            i -= 16;
+            __m512i cur = _mm512_loadu_si512(a + i);
+            __m512i prev = _mm512_loadu_si512(a + i - 1);
+            // Full-mask maskz forms: the unmasked intrinsics trip -Wmaybe-uninitialized on GCC
+            __m512i hi = _mm512_maskz_sll_epi32(0xFFFF, cur, cl);
+            __m512i lo = _mm512_maskz_srl_epi32(0xFFFF, prev, cr);
+            _mm512_storeu_si512(r + i, _mm512_or_si512(hi, lo));
+        }
+        lshift_scalar(r, a, i, s);
+        return out;
+    }
+
+    // Walk from the bottom so every block is read before anything above it is written
+    __attribute__((target("avx2"))) inline uint32_t rshift_avx2(uint32_t *r, const uint32_t *a, size_t n, unsigned s)
+    {
+        uint32_t out = a[0] << (32 - s);
+        const __m128i cl = _mm_cvtsi32_si128(static_cast<int>(32 - s));
+        const __m128i cr = _mm_cvtsi32_si128(static_cast<int>(s));
+        size_t i = 0;
+        for (; i + 9 <= n; i += 8)
+        {
+            __m256i cur = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i + 1));
+            __m256i v = _mm256_or_si256(_mm256_srl_epi32(cur, cr), _mm256_sll_epi32(next, cl));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i), v);
+        }
+        rshift_scalar(r + i, a + i, n - i, s);
+        return out;
+    }
+
+    __attribute__((target("avx512f"))) inline uint32_t rshift_avx512(uint32_t *r, const uint32_t *a, size_t n, unsigned s)
+    {
+        uint32_t out = a[0] << (32 - s);
+        const __m128i cl = _mm_cvtsi32_si128(static_cast<int>(32 - s));
+        const __m128i cr = _mm_cvtsi32_si128(static_cast<int>(s));
+        size_t i = 0;
+        for (; i + 17 <= n; i += 16)
+        {
+            __m512i cur = _mm512_loadu_si512(a + i);
+            __m512i next = _mm512_loadu_si512(a + i + 1);
+            __m512i lo = _mm512_maskz_srl_epi32(0xFFFF, cur, cr);
+            __m512i hi = _mm512_maskz_sll_epi32(0xFFFF, next, cl);
+            _mm512_storeu_si512(r + i, _mm512_or_si512(lo, hi));
+        }
+        rshift_scalar(r + i, a + i, n - i, s);
+        return out;
+    }
+#endif
+
+    // r[0..n) = a[0..n) << s for n >= 1; r == a or r above a is allowed
+    inline uint32_t lshift(uint32_t *r, const uint32_t *a, size_t n, unsigned s)
+    {
+        if (s == 0)
+        {
+            std::memmove(r, a, n * sizeof(uint32_t));
+            return 0;
+        }
+#ifdef BIGINT_X86_SIMD
+        if (n >= SIMD_MIN_LIMBS)
+        {
+            if (cpu_has_avx512())
+                return lshift_avx512(r, a, n, s);
+            if (cpu_has_avx2())
+                return lshift_avx2(r, a, n, s);
+        }
+#endif
+        return lshift_scalar(r, a, n, s);
+    }
+
+    // r[0..n) = a[0..n) >> s for n >= 1; r == a or r below a is allowed
+    inline uint32_t rshift(uint32_t *r, const uint32_t *a, size_t n, unsigned s)
+    {
+        if (s == 0)
+        {
+            std::memmove(r, a, n * sizeof(uint32_t));
+            return 0;
+        }
+#ifdef BIGINT_X86_SIMD
+        if (n >= SIMD_MIN_LIMBS)
+        {
+            if (cpu_has_avx512())
+                return rshift_avx512(r, a, n, s);
+            if (cpu_has_avx2())
+                return rshift_avx2(r, a, n, s);
+        }
+#endif
+        return rshift_scalar(r, a, n, s);
+    }
+
+    // q[0..n) = a[0..n) / d for d != 0, returns the remainder; q may alias a
+    inline uint32_t divrem_1(uint32_t *q, const uint32_t *a, size_t n, uint32_t d)
+    {
+        uint64_t r = 0;
+        for (size_t i = n; i-- > 0;)
+        {
+            uint64_t cur = (r << 32) | a[i];
+            q[i] = static_cast<uint32_t>(cur / d);
+            r = cur % d;
+        }
+        return static_cast<uint32_t>(r);
+    }
+
+    // r[0..n) += a[0..n) * m, returns the carry limb out of the top
+    inline uint32_t addmul_1(uint32_t *r, const uint32_t *a, size_t n, uint32_t m)
+    {
+        uint64_t carry = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            uint64_t p = uint64_t(a[i]) * m + r[i] + carry;
+            r[i] = static_cast<uint32_t>(p);
+            carry = p >> 32;
+        }
+        return static_cast<uint32_t>(carry);
+    }
+
+    // Whether an an x bn product (an >= bn) is cheaper accumulated row by row with
+    // addmul_1/submul_1 than formed separately; mirrors the mul_base/mul dispatch
+    inline bool addmul_direct([[maybe_unused]] size_t an, size_t bn)
+    {
+#ifdef BIGINT_X86_SIMD
+        if (ifma_eligible(an) && ifma_eligible(bn) && cpu_has_ifma())
+            return false;
+#endif
+        return bn < karatsuba_threshold();
+    }
+
+    // r[0..n) -= a[0..n) * m, returns the limb borrowed out of the top
+    inline uint32_t submul_1(uint32_t *r, const uint32_t *a, size_t n, uint32_t m)
+    {
+        uint64_t borrow = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            uint64_t p = uint64_t(a[i]) * m + borrow;
+            uint32_t lo = static_cast<uint32_t>(p);
+            borrow = (p >> 32) + (r[i] < lo);
+            r[i] -= lo;
+        }
+        return static_cast<uint32_t>(borrow);
+    }
+
+    // Schoolbook long division (Knuth's algorithm D): q[0..an-bn] = a / b and
+    // r[0..bn) = a % b, for an >= bn and b[bn-1] != 0. The normalised copies of both
+    // operands live in the scratch arena; q and r may not alias the inputs.
+    inline void divrem(uint32_t *q, uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn)
+    {
+        if (bn == 1)
+        {
+            r[0] = divrem_1(q, a, an, b[0]);
+            return;
+        }
+        ScratchFrame frame;
+        unsigned s = __builtin_clz(b[bn - 1]);
+        uint32_t *v = frame.alloc(bn);
+        uint32_t *u = frame.alloc(an + 1);
+        lshift(v, b, bn, s);
+        u[an] = lshift(u, a, an, s);
+        uint64_t vh = v[bn - 1];
+        uint64_t vl = v[bn - 2];
+        for (size_t j = an - bn + 1; j-- > 0;)
+        {
+            // Estimate from the top two limbs, refined by the next one; at most one
+            // correction is left for the add-back step
+            uint64_t num = (uint64_t(u[j + bn]) << 32) | u[j + bn - 1];
+            uint64_t qhat = num / vh;
+            uint64_t rhat = num % vh;
+            if (qhat > 0xFFFFFFFF)
+            {
+                qhat = 0xFFFFFFFF;
+                rhat = num - qhat * vh;
+            }
+            while (rhat <= 0xFFFFFFFF && qhat * vl > ((rhat << 32) | u[j + bn - 2]))
+            {
+                --qhat;
+                rhat += vh;
+            }
+            uint32_t borrow = submul_1(u + j, v, bn, static_cast<uint32_t>(qhat));
+            uint32_t top = u[j + bn];
+            u[j + bn] = top - borrow;
+            if (top < borrow)
+            {
+                --qhat;
+                u[j + bn] += add_n(u + j, u + j, v, bn);
+            }
+            q[j] = static_cast<uint32_t>(qhat);
+        }
+        rshift(r, u, bn, s);
+    }
+
+    // Text conversion for power-of-two bases
+
+    inline char digit_char(unsigned d, bool upper)
+    {
+        return static_cast<char>(d < 10 ? '0' + d : (upper ? 'A' : 'a') + d - 10);
+    }
+
+    // Value of a digit character in bases up to 36, or 36 for anything else
+    inline unsigned char_digit(char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'z')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'Z')
+            return c - 'A' + 10;
+        return 36;
+    }
+
+    // Eight hex characters per limb, most significant limb first, no zero suppression
+    inline void to_hex_scalar(char *out, const uint32_t *a, size_t n, bool upper)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            uint32_t w = a[n - 1 - i];
+            for (int j = 7; j >= 0; --j, w >>= 4)
+                out[8 * i + j] = digit_char(w & 0xF, upper);
+        }
+    }
+
+#ifdef BIGINT_X86_SIMD
+    // Four limbs per step: byte-reverse to big-endian, widen each byte to a 16-bit lane
+    // holding (low nibble << 8 | high nibble), then map nibbles to ASCII through pshufb
+    __attribute__((target("avx2"))) inline void to_hex_avx2(char *out, const uint32_t *a, size_t n, bool upper)
+    {
+        const __m128i reverse = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+        const __m256i low4 = _mm256_set1_epi16(0x0F);
+        const __m256i lut = upper ? _mm256_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F',
+                                                     '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F')
+                                  : _mm256_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f',
+                                                     '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + n - 4 - i));
+            __m256i w = _mm256_cvtepu8_epi16(_mm_shuffle_epi8(bytes, reverse));
+            __m256i nibbles = _mm256_or_si256(_mm256_srli_epi16(w, 4), _mm256_slli_epi16(_mm256_and_si256(w, low4), 8));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 8 * i), _mm256_shuffle_epi8(lut, nibbles));
+        }
+        to_hex_scalar(out + 8 * i, a, n - i, upper);
+    }
+#endif
+
+    inline void to_hex(char *out, const uint32_t *a, size_t n, bool upper)
+    {
+#ifdef BIGINT_X86_SIMD
+        if (n >= 4 && cpu_has_avx2())
+            return to_hex_avx2(out, a, n, upper);
+#endif
+        to_hex_scalar(out, a, n, upper);
+    }
+
+    // Writes the digits of a[0..n) (top limb non-zero) in base 2^k, k in 1..5, without
+    // leading zeros; out must hold ceil(bits / k) characters. Returns the count written.
+    inline size_t to_pow2_base(char *out, const uint32_t *a, size_t n, unsigned k, bool upper)
+    {
+        size_t bits = 32 * n - __builtin_clz(a[n - 1]);
+        size_t count = (bits + k - 1) / k;
+        if (k == 4)
+        {
+            // Top limb by hand to drop its leading zeros, the rest through the vector kernel
+            size_t top = count - 8 * (n - 1);
+            uint32_t w = a[n - 1];
+            for (size_t j = top; j-- > 0; w >>= 4)
+                out[j] = digit_char(w & 0xF, upper);
+            to_hex(out + top, a, n - 1, upper);
+            return count;
+        }
+        const uint32_t mask = (1u << k) - 1;
+        for (size_t j = 0; j < count; ++j)
+        {
+            size_t bit = (count - 1 - j) * k;
+            size_t w = bit / 32;
+            unsigned sh = bit % 32;
+            uint32_t v = a[w] >> sh;
+            if (sh + k > 32 && w + 1 < n)
+                v |= a[w + 1] << (32 - sh);
+            out[j] = digit_char(v & mask, upper);
+        }
+        return count;
+    }
+
+    // Number-theory helpers
+
+    // Stein's binary GCD on machine words
+    inline uint64_t gcd_u64(uint64_t u, uint64_t v)
+    {
+        if (u == 0)
+            return v;
+        if (v == 0)
+            return u;
+        int shift = __builtin_ctzll(u | v);
+        u >>= __builtin_ctzll(u);
+        do
+        {
+            v >>= __builtin_ctzll(v);
+            if (u > v)
+                std::swap(u, v);
+            v -= u;
+        } while (v != 0);
+        return u << shift;
+    }
+
+    // floor(sqrt(v)), from the double estimate corrected by at most a few steps
+    inline uint64_t isqrt_u64(uint64_t v)
+    {
+        uint64_t s = static_cast<uint64_t>(std::sqrt(static_cast<double>(v)));
+        while (static_cast<unsigned __int128>(s) * s > v)
+            --s;
+        while (static_cast<unsigned __int128>(s + 1) * (s + 1) <= v)
+            ++s;
+        return s;
+    }
+
+    // a[0..n) mod d for d != 0
+    inline uint32_t mod_1(const uint32_t *a, size_t n, uint32_t d)
+    {
+        uint64_t r = 0;
+        for (size_t i = n; i-- > 0;)
+            r = ((r << 32) | a[i]) % d;
+        return static_cast<uint32_t>(r);
+    }
+
+    // b^e mod m for m < 2^32
+    inline uint32_t powmod_u32(uint32_t b, uint64_t e, uint32_t m)
+    {
+        uint64_t r = 1 % m, x = b % m;
+        for (; e != 0; e >>= 1)
+        {
+            if (e & 1)
+                r = r * x % m;
+            x = x * x % m;
+        }
+        return static_cast<uint32_t>(r);
+    }
+
+    // Deterministic for all 32-bit n: trial division for small n, otherwise strong
+    // probable-prime tests to bases 2, 7 and 61
+    inline bool is_prime_u32(uint32_t n)
+    {
+        if (n < 4)
+            return n >= 2;
+        if (n % 2 == 0 || n % 3 == 0)
+            return false;
+        if (n < (1u << 16))
+        {
+            for (uint32_t d = 5; d * d <= n; d += 6)
+            {
+                if (n % d == 0 || n % (d + 2) == 0)
+                    return false;
+            }
+            return true;
+        }
+        uint32_t d = n - 1;
+        int s = __builtin_ctz(d);
+        d >>= s;
+        for (uint32_t a : {2u, 7u, 61u})
+        {
+            uint64_t x = powmod_u32(a, d, n);
+            if (x == 1 || x == n - 1)
+                continue;
+            int r = 1;
+            for (; r < s; ++r)
+            {
+                x = x * x % n;
+                if (x == n - 1)
+                    break;
+            }
+            if (r == s)
+                return false;
+        }
+        return true;
+    }
+
+    // x mod m for x < 2^64 and m < 2^32, given reciprocal = floor((2^64 - 1) / m)
+    inline uint32_t barrett_reduce(uint64_t x, uint32_t m, uint64_t reciprocal)
+    {
+        uint64_t q = static_cast<uint64_t>((static_cast<unsigned __int128>(x) * reciprocal) >> 64);
+        uint64_t r = x - q * m;
+        if (r >= m)
+            r -= m;
+        if (r >= m)
+            r -= m;
+        return static_cast<uint32_t>(r);
+    }
+
+    // Jacobi symbol (a/n) for odd n > 0
+    inline int jacobi_u32(uint32_t a, uint32_t n)
+    {
+        int j = 1;
+        a %= n;
+        while (a != 0)
+        {
+            int tz = __builtin_ctz(a);
+            a >>= tz;
+            if ((tz & 1) && ((n & 7) == 3 || (n & 7) == 5))
+                j = -j;
+            if ((a & 3) == 3 && (n & 3) == 3)
+                j = -j;
+            std::swap(a, n);
+            a %= n;
+        }
+        return n == 1 ? j : 0;
+    }
+
+    // r[j] = a[0..n) mod d[j] for count divisors, in one pass over a
+    inline void mod_1_multi(const uint32_t *a, size_t n, const uint32_t *d, size_t count, uint32_t *r)
+    {
+        std::fill(r, r + count, 0u);
+        for (size_t i = n; i-- > 0;)
+        {
+            for (size_t j = 0; j < count; ++j)
+                r[j] = static_cast<uint32_t>(((uint64_t(r[j]) << 32) | a[i]) % d[j]);
+        }
+    }
+
+    // Odd primes below 1024 for trial division, packed greedily into one-limb products;
+    // primes [group_end[g-1], group_end[g]) divide products[g]
+    struct SmallPrimes
+    {
+        std::vector<uint32_t> primes;
+        std::vector<uint32_t> products;
+        std::vector<size_t> group_end;
+    };
+
+    inline const SmallPrimes &small_primes()
+    {
+        static const SmallPrimes table = [] {
+            SmallPrimes t;
+            uint64_t product = 1;
+            for (uint32_t p = 3; p < 1024; p += 2)
+            {
+                if (!is_prime_u32(p))
+                    continue;
+                if (product * p > 0xFFFFFFFFu)
+                {
+                    t.products.push_back(static_cast<uint32_t>(product));
+                    t.group_end.push_back(t.primes.size());
+                    product = 1;
+                }
+                product *= p;
+                t.primes.push_back(p);
+            }
+            t.products.push_back(static_cast<uint32_t>(product));
+            t.group_end.push_back(t.primes.size());
+            return t;
+        }();
+        return table;
+    }
+
+    // All primes <= n by an odd-only sieve of Eratosthenes
+    inline std::vector<uint32_t> primes_up_to(uint32_t n)
+    {
+        std::vector<uint32_t> primes;
+        if (n < 2)
+            return primes;
+        primes.push_back(2);
+        // composite[i] stands for 2i + 1
+        std::vector<bool> composite(n / 2 + 1);
+        for (uint64_t i = 1; 2 * i + 1 <= n; ++i)
+        {
+            if (composite[i])
+                continue;
+            uint64_t p = 2 * i + 1;
+            primes.push_back(static_cast<uint32_t>(p));
+            for (uint64_t j = p * p / 2; j <= n / 2; j += p)
+                composite[j] = true;
+        }
+        return primes;
+    }
+
+    // -n^-1 mod 2^32 for odd n0, by Newton's iteration (3 correct bits, doubling)
+    inline uint32_t mont_ninv(uint32_t n0)
+    {
+        uint32_t inv = n0;
+        for (int i = 0; i < 4; ++i)
+            inv *= 2 - n0 * inv;
+        return -inv;
+    }
+
+    // Montgomery product r = a*b/R mod n, R = 2^(32k), for a, b < n (CIOS: one
+    // multiply and one reduction row per limb of b). t holds k + 2 limbs; r may alias
+    // a or b.
+    inline void mont_mul(uint32_t *r, const uint32_t *a, const uint32_t *b, const uint32_t *n, size_t k,
+                         uint32_t ninv, uint32_t *t)
+    {
+        std::fill(t, t + k + 2, 0u);
+        for (size_t i = 0; i < k; ++i)
+        {
+            uint64_t c = 0;
+            for (size_t j = 0; j < k; ++j)
+            {
+                c += t[j] + uint64_t(a[j]) * b[i];
+                t[j] = static_cast<uint32_t>(c);
+                c >>= 32;
+            }
+            c += t[k];
+            t[k] = static_cast<uint32_t>(c);
+            t[k + 1] = static_cast<uint32_t>(c >> 32);
+            uint32_t m = t[0] * ninv;
+            c = (t[0] + uint64_t(m) * n[0]) >> 32;
+            for (size_t j = 1; j < k; ++j)
+            {
+                c += t[j] + uint64_t(m) * n[j];
+                t[j - 1] = static_cast<uint32_t>(c);
+                c >>= 32;
+            }
+            c += t[k];
+            t[k - 1] = static_cast<uint32_t>(c);
+            t[k] = t[k + 1] + static_cast<uint32_t>(c >> 32);
+        }
+        if (t[k] != 0 || cmp_n(t, n, k) >= 0)
+            sub_n(r, t, n, k);
+        else
+            std::copy(t, t + k, r);
+    }
+
+    // Bit j set iff j is a square modulo m, for m <= 64
+    constexpr uint64_t square_residues(unsigned m)
+    {
+        uint64_t mask = 0;
+        for (unsigned j = 0; j < m; ++j)
+            mask |= uint64_t(1) << (j * j % m);
+        return mask;
+    }
+
+    // len <= 64 bits of a[0..n) starting at bit pos; bits past the end read as zero
+    inline uint64_t extract_bits(const uint32_t *a, size_t n, size_t pos, unsigned len)
+    {
+        size_t w = pos / 32;
+        unsigned __int128 v = 0;
+        for (size_t j = 0; j < 3 && w + j < n; ++j)
+            v |= static_cast<unsigned __int128>(a[w + j]) << (32 * j);
+        v >>= pos % 32;
+        return static_cast<uint64_t>(v) & (len == 64 ? ~uint64_t(0) : (uint64_t(1) << len) - 1);
+    }
+
+    // Lehmer cosequence step applied in one pass: a, b = A*a - B*b, D*b - C*a.
+    // Both results must be non-negative; b is zero-extended to n limbs by the caller.
+    inline void lehmer_update(uint32_t *a, uint32_t *b, size_t n, int64_t A, int64_t B, int64_t C, int64_t D)
+    {
+        __int128 ca = 0, cb = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            __int128 ai = a[i], bi = b[i];
+            ca += A * ai - B * bi;
+            cb += D * bi - C * ai;
+            a[i] = static_cast<uint32_t>(ca);
+            b[i] = static_cast<uint32_t>(cb);
+            ca >>= 32;
+            cb >>= 32;
+        }
+    }
+
+    // Half-GCD on the leading double limbs a = ah:al, b = bh:bl (after GMP's mpn_hgcd2).
+    // On success, u = {u00, u01, u10, u11} with det 1 satisfies (a; b) = u (a'; b')
+    // for remainders a', b' that are still correct for the full-precision operands.
+    inline bool hgcd2(uint32_t ah, uint32_t al, uint32_t bh, uint32_t bl, uint32_t *u)
+    {
+        constexpr uint32_t HALF = uint32_t(1) << 16;
+        constexpr uint32_t STOP = uint32_t(1) << 17;
+        uint64_t a = (uint64_t(ah) << 32) | al;
+        uint64_t b = (uint64_t(bh) << 32) | bl;
+        uint32_t u00, u01, u10, u11;
+        if (ah < 2 || bh < 2)
+            return false;
+        if (a > b)
+        {
+            a -= b;
+            if ((a >> 32) < 2)
+                return false;
+            u00 = u01 = u11 = 1;
+            u10 = 0;
+        }
+        else
+        {
+            b -= a;
+            if ((b >> 32) < 2)
+                return false;
+            u00 = u10 = u11 = 1;
+            u01 = 0;
+        }
+        // Double-precision phase: quotients come from the full 64 bits, the stopping
+        // test looks at the high limb only
+        bool reduce_a = (a >> 32) >= (b >> 32);
+        for (;;)
+        {
+            uint32_t hi_a = static_cast<uint32_t>(a >> 32);
+            uint32_t hi_b = static_cast<uint32_t>(b >> 32);
+            if (hi_a == hi_b)
+                goto done;
+            if (reduce_a)
+            {
+                if (hi_a < HALF)
+                    break;
+                a -= b;
+                if ((a >> 32) < 2)
+                    goto done;
+                if ((a >> 32) <= hi_b)
+                {
+                    u01 += u00;
+                    u11 += u10;
+                }
+                else
+                {
+                    uint32_t q = static_cast<uint32_t>(a / b);
+                    a %= b;
+                    if ((a >> 32) < 2)
+                    {
+                        u01 += q * u00;
+                        u11 += q * u10;
+                        goto done;
+                    }
+                    ++q;
+                    u01 += q * u00;
+                    u11 += q * u10;
+                }
+            }
+            else
+            {
+                if (hi_b < HALF)
+                    break;
+                b -= a;
+                if ((b >> 32) < 2)
+                    goto done;
+                if ((b >> 32) <= hi_a)
+                {
+                    u00 += u01;
+                    u10 += u11;
+                }
+                else
+                {
+                    uint32_t q = static_cast<uint32_t>(b / a);
+                    b %= a;
+                    if ((b >> 32) < 2)
+                    {
+                        u00 += q * u01;
+                        u10 += q * u11;
+                        goto done;
+                    }
+                    ++q;
+                    u00 += q * u01;
+                    u10 += q * u11;
+                }
+            }
+            reduce_a = !reduce_a;
+        }
+        // Single-precision phase on the top 48 bits; the low half limb is dropped,
+        // so the result is slightly short of maximal
+        {
+            uint32_t x = static_cast<uint32_t>(a >> 16);
+            uint32_t y = static_cast<uint32_t>(b >> 16);
+            for (;;)
+            {
+                if (reduce_a)
+                {
+                    x -= y;
+                    if (x < STOP)
+                        break;
+                    if (x <= y)
+                    {
+                        u01 += u00;
+                        u11 += u10;
+                    }
+                    else
+                    {
+                        uint32_t q = x / y;
+                        x %= y;
+                        if (x < STOP)
+                        {
+                            u01 += q * u00;
+                            u11 += q * u10;
+                            break;
+                        }
+                        ++q;
+                        u01 += q * u00;
+                        u11 += q * u10;
+                    }
+                }
+                else
+                {
+                    y -= x;
+                    if (y < STOP)
+                        break;
+                    if (y <= x)
+                    {
+                        u00 += u01;
+                        u10 += u11;
+                    }
+                    else
+                    {
+                        uint32_t q = y / x;
+                        y %= x;
+                        if (y < STOP)
+                        {
+                            u00 += q * u01;
+                            u10 += q * u11;
+                            break;
+                        }
+                        ++q;
+                        u00 += q * u01;
+                        u10 += q * u11;
+                    }
+                }
+                reduce_a = !reduce_a;
+            }
+        }
+    done:
+        u[0] = u00;
+        u[1] = u01;
+        u[2] = u10;
+        u[3] = u11;
+        return true;
+    }
+}
+
+template <typename Alloc = std::allocator<uint32_t>>
+struct BasicBigInt;
+
+template <typename Alloc = std::allocator<uint32_t>>
+class BasicSharedBigInt;
+
+// Binary record format, version 1: a 16-byte header, then the limbs least significant
+// first, then zero padding to a multiple of 16 bytes, so records written back to back
+// (or mapped from a file) keep their limbs 16-byte aligned. The limb count and the limbs
+// are in the writer's byte order, which the single-byte endian tag records; readers on
+// the other order swap them, but only native-order records can be loaded as views.
+namespace serial
+{
+    struct Header
+    {
+        char magic[4]; // "BINT"
+        uint8_t version;
+        uint8_t endian; // LITTLE or BIG
+        uint8_t flags;  // bit 0: negative
+        uint8_t reserved;
+        uint64_t limbs;
+    };
+    static_assert(sizeof(Header) == 16);
+
+    constexpr uint8_t VERSION = 1;
+    constexpr uint8_t LITTLE = 1;
+    constexpr uint8_t BIG = 2;
+    constexpr uint8_t NATIVE = std::endian::native == std::endian::little ? LITTLE : BIG;
+    constexpr uint8_t FLAG_NEGATIVE = 1;
+    constexpr size_t ALIGN = 16;
+
+    inline size_t record_size(size_t limbs)
+    {
+        return sizeof(Header) + (limbs * sizeof(uint32_t) + ALIGN - 1) / ALIGN * ALIGN;
+    }
+
+    inline Header make_header(size_t limbs, bool negative)
+    {
+        return {{'B', 'I', 'N', 'T'}, VERSION, NATIVE, uint8_t(negative ? FLAG_NEGATIVE : 0), 0, limbs};
+    }
+
+    // Checks h and converts its limb count to native order; `swap` tells whether the
+    // limbs that follow need byte swapping
+    inline void check_header(Header &h, bool &swap)
+    {
+        if (std::memcmp(h.magic, "BINT", 4) != 0)
+            throw std::invalid_argument("BigInt::deserialize: bad magic");
+        if (h.version != VERSION)
+            throw std::invalid_argument("BigInt::deserialize: unsupported version " + std::to_string(h.version));
+        if (h.endian != LITTLE && h.endian != BIG)
+            throw std::invalid_argument("BigInt::deserialize: bad endian tag");
+        swap = h.endian != NATIVE;
+        if (swap)
+            h.limbs = __builtin_bswap64(h.limbs);
+    }
+
+    // Reads and checks the header at the front of `in`, and checks that the whole record fits
+    inline Header read_header(std::span<const std::byte> in, bool &swap)
+    {
+        Header h;
+        if (in.size() < sizeof(Header))
+            throw std::invalid_argument("BigInt::deserialize: truncated input");
+        std::memcpy(&h, in.data(), sizeof(Header));
+        check_header(h, swap);
+        if (h.limbs > (in.size() - sizeof(Header)) / sizeof(uint32_t))
+            throw std::invalid_argument("BigInt::deserialize: truncated input");
+        return h;
+    }
+
+    // Compact wire encoding, for payloads dominated by small values. Every value starts
+    // with an LEB128 varint (7 bits per byte, low group first, high bit on all but the
+    // last byte) whose low bit selects the form:
+    //   short (bit 0 clear): the rest is the zigzag sign-magnitude (2|x| or 2|x| - 1),
+    //                        for |x| < 2^62, so |x| < 32 takes a single byte;
+    //   long (bit 0 set):    bit 1 is the sign and the rest the limb count, followed by
+    //                        the limbs as 4-byte little-endian words.
+    // Unlike the record format this one is byte-order independent and unaligned.
+    constexpr uint64_t COMPACT_SHORT_LIMIT = uint64_t(1) << 62;
+
+    inline size_t varint_size(uint64_t v)
+    {
+        return v < 0x80 ? 1 : (std::bit_width(v) + 6) / 7;
+    }
+
+    inline size_t put_varint_scalar(std::byte *out, uint64_t v)
+    {
+        size_t n = 0;
+        for (; v >= 0x80; v >>= 7)
+            out[n++] = std::byte(v | 0x80);
+        out[n++] = std::byte(v);
+        return n;
+    }
+
+    // Decodes the varint at p, returns its length or 0 if it is truncated or overlong
+    inline size_t get_varint_scalar(const std::byte *p, const std::byte *end, uint64_t &v)
+    {
+        uint64_t r = 0;
+        for (size_t i = 0; i < 10 && p + i < end; ++i)
+        {
+            uint64_t b = static_cast<uint64_t>(p[i]);
+            if (i == 9 && b > 1)
+                return 0;
+            r |= (b & 0x7f) << (7 * i);
+            if (!(b & 0x80))
+            {
+                v = r;
+                return i + 1;
+            }
+        }
+        return 0;
+    }
+
+#ifdef BIGINT_X86_SIMD
+    constexpr uint64_t VARINT_GROUPS = 0x7f7f7f7f7f7f7f7f;
+    constexpr uint64_t VARINT_STOPS = 0x8080808080808080;
+
+    // Varints of up to 8 bytes in one pdep/pext each. The decoder reads 8 bytes at p;
+    // the encoder stores all 8 only when the caller marks the bytes past the varint
+    // as scratch (slack), otherwise just the n it encodes.
+    __attribute__((target("bmi2"))) inline size_t put_varint_bmi2(std::byte *out, uint64_t v, bool slack)
+    {
+        if (v >> 56)
+            return put_varint_scalar(out, v);
+        size_t n = varint_size(v);
+        uint64_t w = _pdep_u64(v, VARINT_GROUPS) | (VARINT_STOPS & ((uint64_t(1) << (8 * n - 8)) - 1));
+        std::memcpy(out, &w, slack ? 8 : n);
+        return n;
+    }
+
+    __attribute__((target("bmi2"))) inline size_t get_varint_bmi2(const std::byte *p, uint64_t &v)
+    {
+        uint64_t w;
+        std::memcpy(&w, p, 8);
+        uint64_t stops = ~w & VARINT_STOPS;
+        if (!stops)
+            return 0;
+        v = _pext_u64(w & (stops ^ (stops - 1)), VARINT_GROUPS);
+        return (std::countr_zero(stops) >> 3) + 1;
+    }
+#endif
+
+    // Writes v at out. With slack the 8 bytes at out may all be overwritten; without
+    // it only the varint's own bytes are touched.
+    inline size_t put_varint(std::byte *out, uint64_t v, bool slack = false)
+    {
+#ifdef BIGINT_X86_SIMD
+        if (limb_ops::cpu_has_bmi2())
+            return put_varint_bmi2(out, v, slack);
+#endif
+        (void)slack;
+        return put_varint_scalar(out, v);
+    }
+
+    inline size_t get_varint(const std::byte *p, const std::byte *end, uint64_t &v)
+    {
+#ifdef BIGINT_X86_SIMD
+        if (end - p >= 8 && limb_ops::cpu_has_bmi2())
+        {
+            if (size_t n = get_varint_bmi2(p, v))
+                return n;
+        }
+#endif
+        return get_varint_scalar(p, end, v);
+    }
+
+    // Leading varint of a value with the given (normalised) limbs
+    inline uint64_t compact_head(std::span<const uint32_t> limbs, bool negative)
+    {
+        uint64_t m = 0;
+        if (limbs.size() <= 2)
+        {
+            for (size_t i = limbs.size(); i-- > 0;)
+                m = (m << 32) | limbs[i];
+            if (m < COMPACT_SHORT_LIMIT)
+                return ((m << 1) - (negative && m ? 1 : 0)) << 1;
+        }
+        return (uint64_t(limbs.size()) << 2) | (negative ? 2 : 0) | 1;
+    }
+
+    inline size_t compact_size(std::span<const uint32_t> limbs, bool negative)
+    {
+        uint64_t head = compact_head(limbs, negative);
+        return varint_size(head) + ((head & 1) ? limbs.size() * sizeof(uint32_t) : 0);
+    }
+
+    // Encodes at out, which must hold compact_size bytes (8 more with slack, see
+    // put_varint); returns the bytes written
+    inline size_t encode_compact(std::byte *out, std::span<const uint32_t> limbs, bool negative, bool slack = false)
+    {
+        uint64_t head = compact_head(limbs, negative);
+        size_t n = put_varint(out, head, slack);
+        if (!(head & 1))
+            return n;
+        for (uint32_t d : limbs)
+        {
+            for (int k = 0; k < 4; ++k)
+                out[n + k] = std::byte(d >> (8 * k));
+            n += 4;
+        }
+        return n;
+    }
+}
+
+// Non-owning, read-only view of an integer: a sign and limbs (least significant first)
+// that may live anywhere, such as a mapped file, a network buffer or one column of an
+// SoA array. Views over raw limbs are normalised on construction (high zero limbs are
+// dropped and zero is non-negative), so they compare and hash like the equal number.
+// Every read-only operand accepts a view; results are ordinary numbers. The limbs must
+// outlive the view.
+struct BigIntView
+{
+    std::span<const uint32_t> limbs;
+    bool negative = false;
+
+    BigIntView() = default;
+
+    explicit BigIntView(std::span<const uint32_t> l, bool neg = false) : limbs(l), negative(neg)
+    {
+        while (!limbs.empty() && limbs.back() == 0)
+            limbs = limbs.first(limbs.size() - 1);
+        if (limbs.empty())
+            negative = false;
+    }
+
+    template <typename Alloc>
+    BigIntView(const BasicBigInt<Alloc> &x) : limbs(x.digits), negative(x.negative)
+    {
+    }
+
+    template <typename Alloc>
+    BigIntView(const BasicSharedBigInt<Alloc> &x) : BigIntView(x.get())
+    {
+    }
+
+    bool isZero() const
+    {
+        return limbs.empty();
+    }
+
+    size_t bit_length() const
+    {
+        if (limbs.empty())
+            return 0;
+        return 32 * limbs.size() - __builtin_clz(limbs.back());
+    }
+
+    std::string to_string(int base = 10, bool upper = false) const;
+
+    // Binary record (see namespace serial)
+    size_t serialized_size() const
+    {
+        return serial::record_size(limbs.size());
+    }
+
+    // Writes the record to the front of out and returns its size
+    size_t serialize(std::span<std::byte> out) const
+    {
+        size_t size = serialized_size();
+        if (out.size() < size)
+            throw std::invalid_argument("BigInt::serialize: buffer too small");
+        serial::Header h = serial::make_header(limbs.size(), negative);
+        size_t payload = limbs.size() * sizeof(uint32_t);
+        std::memcpy(out.data(), &h, sizeof(h));
+        if (payload)
+            std::memcpy(out.data() + sizeof(h), limbs.data(), payload);
+        std::memset(out.data() + sizeof(h) + payload, 0, size - sizeof(h) - payload);
+        return size;
+    }
+
+    void serialize(std::ostream &os) const
+    {
+        static constexpr char zeros[serial::ALIGN] = {};
+        serial::Header h = serial::make_header(limbs.size(), negative);
+        size_t payload = limbs.size() * sizeof(uint32_t);
+        os.write(reinterpret_cast<const char *>(&h), sizeof(h));
+        os.write(reinterpret_cast<const char *>(limbs.data()), static_cast<std::streamsize>(payload));
+        os.write(zeros, static_cast<std::streamsize>(serialized_size() - sizeof(h) - payload));
+    }
+
+    // Compact wire encoding (see namespace serial)
+    size_t compact_size() const
+    {
+        return serial::compact_size(limbs, negative);
+    }
+
+    size_t encode_compact(std::span<std::byte> out) const
+    {
+        if (out.size() < compact_size())
+            throw std::invalid_argument("BigInt::encode_compact: buffer too small");
+        return serial::encode_compact(out.data(), limbs, negative);
+    }
+
+    // Views the limbs of the record at the front of in without copying them. The record
+    // must be in native byte order and its limbs 4-byte aligned, as they are in a buffer
+    // or mapping that starts on a record boundary.
+    static BigIntView load(std::span<const std::byte> in, size_t *consumed = nullptr)
+    {
+        bool swap;
+        serial::Header h = serial::read_header(in, swap);
+        if (swap)
+            throw std::invalid_argument("BigInt::deserialize: record is not in native byte order");
+        const std::byte *p = in.data() + sizeof(h);
+        if (reinterpret_cast<uintptr_t>(p) % alignof(uint32_t) != 0)
+            throw std::invalid_argument("BigInt::deserialize: misaligned record");
+        if (consumed)
+            *consumed = std::min(in.size(), serial::record_size(h.limbs));
+        return BigIntView(std::span<const uint32_t>(reinterpret_cast<const uint32_t *>(p), h.limbs),
+                          (h.flags & serial::FLAG_NEGATIVE) != 0);
+    }
+
+    size_t hash() const
+    {
+        std::string_view bytes(reinterpret_cast<const char *>(limbs.data()), limbs.size() * sizeof(uint32_t));
+        return std::hash<std::string_view>{}(bytes) ^ (negative ? 0x9e3779b97f4a7c15 : 0);
+    }
+};
+
+// Opt-in lazy arithmetic. lazy(x) wraps a number so that +, - and * build a tree of
+// references instead of values. Assigning the tree to a BasicBigInt flattens it into a
+// signed sum of plain values and two-factor products, which are accumulated straight
+// into the destination (products through the addmul/submul kernels), so no intermediate
+// number is created. Nodes hold references: consume an expression in the statement
+// that builds it rather than keeping it in an `auto` variable.
+namespace expr
+{
+    template <typename Alloc>
+    struct Term
+    {
+        const BasicBigInt<Alloc> *x;
+        const BasicBigInt<Alloc> *y; // second factor, null for a plain value
+        bool negative;
+    };
+
+    template <typename Alloc>
+    struct Value
+    {
+        using allocator_type = Alloc;
+        static constexpr size_t terms = 1;
+        const BasicBigInt<Alloc> &x;
+
+        const BasicBigInt<Alloc> &first() const
+        {
+            return x;
+        }
+
+        void collect(Term<Alloc> *out, bool negative) const
+        {
+            *out = {&x, nullptr, negative};
+        }
+    };
+
+    template <typename Alloc>
+    struct Product
+    {
+        using allocator_type = Alloc;
+        static constexpr size_t terms = 1;
+        const BasicBigInt<Alloc> &x;
+        const BasicBigInt<Alloc> &y;
+
+        const BasicBigInt<Alloc> &first() const
+        {
+            return x;
+        }
+
+        void collect(Term<Alloc> *out, bool negative) const
+        {
+            *out = {&x, &y, negative};
+        }
+    };
+
+    template <typename L, typename R, bool Subtract>
+    struct Sum
+    {
+        using allocator_type = typename L::allocator_type;
+        static constexpr size_t terms = L::terms + R::terms;
+        L l;
+        R r;
+
+        const BasicBigInt<allocator_type> &first() const
+        {
+            return l.first();
+        }
+
+        void collect(Term<allocator_type> *out, bool negative) const
+        {
+            l.collect(out, negative);
+            r.collect(out + L::terms, negative != Subtract);
+        }
+    };
+
+    template <typename E>
+    struct Negate
+    {
+        using allocator_type = typename E::allocator_type;
+        static constexpr size_t terms = E::terms;
+        E e;
+
+        const BasicBigInt<allocator_type> &first() const
+        {
+            return e.first();
+        }
+
+        void collect(Term<allocator_type> *out, bool negative) const
+        {
+            e.collect(out, !negative);
+        }
+    };
+
+    template <typename E>
+    concept Expression = requires(const E &e, Term<typename E::allocator_type> *out) {
+        { E::terms } -> std::convertible_to<size_t>;
+        e.collect(out, false);
+        e.first();
+    };
+
+    template <typename L, typename R>
+    concept SameAllocator = std::same_as<typename L::allocator_type, typename R::allocator_type>;
+
+    // Products: of two values only; a product of sums has no fused form
+    template <typename Alloc>
+    Product<Alloc> operator*(Value<Alloc> a, Value<Alloc> b)
+    {
+        return {a.x, b.x};
+    }
+
+    template <typename Alloc>
+    Product<Alloc> operator*(Value<Alloc> a, const BasicBigInt<Alloc> &b)
+    {
+        return {a.x, b};
+    }
+
+    template <typename Alloc>
+    Product<Alloc> operator*(const BasicBigInt<Alloc> &a, Value<Alloc> b)
+    {
+        return {a, b.x};
+    }
+
+    template <Expression L, Expression R>
+        requires SameAllocator<L, R>
+    Sum<L, R, false> operator+(L l, R r)
+    {
+        return {l, r};
+    }
+
+    template <Expression L, typename Alloc>
+        requires std::same_as<typename L::allocator_type, Alloc>
+    Sum<L, Value<Alloc>, false> operator+(L l, const BasicBigInt<Alloc> &r)
+    {
+        return {l, {r}};
+    }
+
+    template <typename Alloc, Expression R>
+        requires std::same_as<typename R::allocator_type, Alloc>
+    Sum<Value<Alloc>, R, false> operator+(const BasicBigInt<Alloc> &l, R r)
+    {
+        return {{l}, r};
+    }
+
+    template <Expression L, Expression R>
+        requires SameAllocator<L, R>
+    Sum<L, R, true> operator-(L l, R r)
+    {
+        return {l, r};
+    }
+
+    template <Expression L, typename Alloc>
+        requires std::same_as<typename L::allocator_type, Alloc>
+    Sum<L, Value<Alloc>, true> operator-(L l, const BasicBigInt<Alloc> &r)
+    {
+        return {l, {r}};
+    }
+
+    template <typename Alloc, Expression R>
+        requires std::same_as<typename R::allocator_type, Alloc>
+    Sum<Value<Alloc>, R, true> operator-(const BasicBigInt<Alloc> &l, R r)
+    {
+        return {{l}, r};
+    }
+
+    template <Expression E>
+    Negate<E> operator-(E e)
+    {
+        return {e};
+    }
+}
+
+// Arbitrary-precision integer whose limbs are allocated through Alloc. Every result
+// takes the allocator of its left (or only) operand, so values derived from a number
+// placed in an arena stay in that arena. Plain copies follow the container rules
+// (select_on_container_copy_construction); BasicBigInt(other, alloc) pins one.
+template <typename Alloc>
+struct BasicBigInt
+{
+    using allocator_type = Alloc;
+
+    // Internal representation: least significant digit first
+    std::vector<uint32_t, Alloc> digits; // base 2^32
+    bool negative;
+
+    // Constructors
+    BasicBigInt() : negative(false) {}
+
+    explicit BasicBigInt(const Alloc &alloc) : digits(alloc), negative(false) {}
+
+    BasicBigInt(const BasicBigInt &other) = default;
+    BasicBigInt(BasicBigInt &&other) = default;
+    BasicBigInt &operator=(const BasicBigInt &other) = default;
+    BasicBigInt &operator=(BasicBigInt &&other) = default;
+
+    // Allocator-extended copy
+    BasicBigInt(const BasicBigInt &other, const Alloc &alloc) : digits(other.digits, alloc), negative(other.negative) {}
+
+    // Copies the limbs of a view
+    template <std::same_as<BigIntView> V>
+    explicit BasicBigInt(V v, const Alloc &alloc = Alloc()) : digits(v.limbs.begin(), v.limbs.end(), alloc), negative(v.negative)
+    {
+    }
+
+    // Evaluates a lazy expression, with the allocator of its leftmost operand
+    template <expr::Expression E>
+        requires std::same_as<typename E::allocator_type, Alloc>
+    BasicBigInt(const E &e) : digits(e.first().get_allocator()), negative(false)
+    {
+        evaluate(e, false, false);
+    }
+
+    template <expr::Expression E>
+        requires std::same_as<typename E::allocator_type, Alloc>
+    BasicBigInt &operator=(const E &e)
+    {
+        evaluate(e, false, false);
+        return *this;
+    }
+
+    template <expr::Expression E>
+        requires std::same_as<typename E::allocator_type, Alloc>
+    BasicBigInt &operator+=(const E &e)
+    {
+        evaluate(e, true, false);
+        return *this;
+    }
+
+    template <expr::Expression E>
+        requires std::same_as<typename E::allocator_type, Alloc>
+    BasicBigInt &operator-=(const E &e)
+    {
+        evaluate(e, true, true);
+        return *this;
+    }
+
+    BasicBigInt(const std::string &s, const Alloc &alloc = Alloc()) : digits(alloc)
+    {
+        negative = false;
+        std::string str = s;
+        if (str[0] == '-')
+        {
+            negative = true;
+            str = str.substr(1);
+        }
+
+        // Remove leading zeros
+        while (str.size() > 1 && str[0] == '0')
+            str.erase(0, 1);
+
+        digits.clear();
+        BasicBigInt result(0, alloc);
+        for (char c : str)
+        {
+            result = result * 10 + BasicBigInt(c - '0');
+        }
+        digits = result.digits;
+    }
+
+    BasicBigInt(int value, const Alloc &alloc = Alloc()) : digits(alloc)
+    {
+        if (value < 0)
+        {
+            negative = true;
+            value = -value;
+        }
+        else
+        {
+            negative = false;
+        }
+        if (value != 0)
+            digits.push_back(static_cast<uint32_t>(value));
+    }
+
+    BasicBigInt(uint32_t value, const Alloc &alloc = Alloc()) : digits(alloc), negative(false)
+    {
+        if (value != 0)
+            digits.push_back(value);
+    }
+
+    BasicBigInt(int64_t value, const Alloc &alloc = Alloc()) : digits(alloc)
+    {
+        if (value < 0)
+        {
+            negative = true;
+            value = -value;
+        }
+        else
+        {
+            negative = false;
+        }
+        if (value != 0)
+        {
+            digits.push_back(static_cast<uint32_t>(value & 0xFFFFFFFF));
+            if (value > 0xFFFFFFFF)
+                digits.push_back(static_cast<uint32_t>((value >> 32) & 0xFFFFFFFF));
+        }
+    }
+
+    BasicBigInt(uint64_t value, const Alloc &alloc = Alloc()) : digits(alloc), negative(false)
+    {
+        if (value != 0)
+        {
+            digits.push_back(static_cast<uint32_t>(value & 0xFFFFFFFF));
+            if (value > 0xFFFFFFFF)
+                digits.push_back(static_cast<uint32_t>(value >> 32));
+        }
+    }
+
+    allocator_type get_allocator() const
+    {
+        return digits.get_allocator();
+    }
+
+    // Helper functions
+    // Zero is always stored as an empty, non-negative digit vector
+    void trim()
+    {
+        while (!digits.empty() && digits.back() == 0)
+            digits.pop_back();
+        if (digits.empty())
+            negative = false;
+    }
+
+    bool isZero() const
+    {
+        return digits.empty() || (digits.size() == 1 && digits[0] == 0);
+    }
+
+    BasicBigInt abs() const
+    {
+        BasicBigInt result(*this, get_allocator());
+        result.negative = false;
+        return result;
+    }
+
+    // Addition
+    BasicBigInt operator+(const BasicBigInt &other) const
+    {
+        return sum_of(*this, other, false, get_allocator());
+    }
+
+    // Unary minus
+    BasicBigInt operator-() const
+    {
+        BasicBigInt result(*this, get_allocator());
+        if (!isZero())
+            result.negative = !negative;
+        return result;
+    }
+
+    // Subtraction
+    BasicBigInt operator-(const BasicBigInt &other) const
+    {
+        return sum_of(*this, other, true, get_allocator());
+    }
+
+    // In-place addition and subtraction, growing the limb buffer only on a carry out
+    BasicBigInt &operator+=(const BasicBigInt &other)
+    {
+        add_signed(other, other.negative);
+        return *this;
+    }
+
+    BasicBigInt &operator-=(const BasicBigInt &other)
+    {
+        add_signed(other, !other.negative);
+        return *this;
+    }
+
+    // Multiplication
+    BasicBigInt operator*(const BasicBigInt &other) const
+    {
+        return product_of(*this, other, get_allocator());
+    }
+
+    // The product is formed in scratch and copied back, so the buffer is only
+    // reallocated when its capacity is too small; a one-limb factor works in place
+    BasicBigInt &operator*=(const BasicBigInt &other)
+    {
+        multiply_by(other);
+        return *this;
+    }
+
+    // this += a * b (addmul) and this -= a * b (submul) without a product temporary.
+    // Narrow products are accumulated row by row into these limbs; wide ones are formed
+    // in the scratch arena, which every call on the thread shares.
+    BasicBigInt &addmul(const BasicBigInt &a, const BasicBigInt &b)
+    {
+        add_product(a, b, false);
+        return *this;
+    }
+
+    BasicBigInt &submul(const BasicBigInt &a, const BasicBigInt &b)
+    {
+        add_product(a, b, true);
+        return *this;
+    }
+
+    // Division and Modulo
+    BasicBigInt operator/(const BasicBigInt &other) const
+    {
+        BasicBigInt quotient(get_allocator()), remainder(get_allocator());
+        divmod(*this, other, quotient, remainder);
+        return quotient;
+    }
+
+    BasicBigInt operator%(const BasicBigInt &other) const
+    {
+        BasicBigInt quotient(get_allocator()), remainder(get_allocator());
+        divmod(*this, other, quotient, remainder);
+        return remainder;
+    }
+
+    // Bitwise operators, with two's-complement semantics for negative values. The
+    // shifts are the exception: >> truncates toward zero like /, so -5 >> 1 == -2;
+    // fdiv_q_2exp gives the floor that matches these operators.
+    BasicBigInt operator&(const BasicBigInt &other) const
+    {
+        BasicBigInt result(get_allocator());
+        bitwise<limb_ops::BIT_AND>(result, *this, other);
+        return result;
+    }
+
+    BasicBigInt operator|(const BasicBigInt &other) const
+    {
+        BasicBigInt result(get_allocator());
+        bitwise<limb_ops::BIT_OR>(result, *this, other);
+        return result;
+    }
+
+    BasicBigInt operator^(const BasicBigInt &other) const
+    {
+        BasicBigInt result(get_allocator());
+        bitwise<limb_ops::BIT_XOR>(result, *this, other);
+        return result;
+    }
+
+    // ~x == -x - 1
+    BasicBigInt operator~() const
+    {
+        BasicBigInt result(get_allocator());
+        bitwise<limb_ops::BIT_NOT>(result, *this, *this);
+        return result;
+    }
+
+    BasicBigInt &operator&=(const BasicBigInt &other)
+    {
+        bitwise<limb_ops::BIT_AND>(*this, *this, other);
+        return *this;
+    }
+
+    BasicBigInt &operator|=(const BasicBigInt &other)
+    {
+        bitwise<limb_ops::BIT_OR>(*this, *this, other);
+        return *this;
+    }
+
+    BasicBigInt &operator^=(const BasicBigInt &other)
+    {
+        bitwise<limb_ops::BIT_XOR>(*this, *this, other);
+        return *this;
+    }
+
+    // String conversion in bases 2, 8, 10, 16 and 32. Power-of-two bases map bits to
+    // digits directly and run in linear time; digits above 9 are a-v (A-V when upper).
+    std::string to_string(int base = 10, bool upper = false) const
+    {
+        if (isZero())
+            return "0";
+        std::string s;
+        if (base == 10)
+        {
+            BasicBigInt temp = abs();
+            while (!temp.isZero())
+            {
+                uint32_t remainder = temp.divmod_small(10);
+                s.push_back(static_cast<char>('0' + remainder));
+            }
+            if (negative)
+                s.push_back('-');
+            std::reverse(s.begin(), s.end());
+            return s;
+        }
+        unsigned k = pow2_base_bits(base);
+        size_t sign = negative ? 1 : 0;
+        s.resize(sign + (bit_length() + k - 1) / k);
+        if (negative)
+            s[0] = '-';
+        limb_ops::to_pow2_base(&s[sign], digits.data(), digits.size(), k, upper);
+        return s;
+    }
+
+    static BasicBigInt from_string(const std::string &s, int base = 10, const Alloc &alloc = Alloc())
+    {
+        if (base == 10)
+            return from_decimal(s, alloc);
+        unsigned k = pow2_base_bits(base);
+        size_t start = !s.empty() && (s[0] == '-' || s[0] == '+') ? 1 : 0;
+        if (start == s.size())
+            throw std::invalid_argument("BigInt::from_string: no digits");
+        BasicBigInt result(alloc);
+        result.digits.reserve(((s.size() - start) * k + 31) / 32);
+        uint64_t acc = 0;
+        unsigned acc_bits = 0;
+        for (size_t i = s.size(); i-- > start;)
+        {
+            unsigned d = limb_ops::char_digit(s[i]);
+            if (d >= static_cast<unsigned>(base))
+                throw std::invalid_argument("BigInt::from_string: invalid digit");
+            acc |= uint64_t(d) << acc_bits;
+            acc_bits += k;
+            if (acc_bits >= 32)
+            {
+                result.digits.push_back(static_cast<uint32_t>(acc));
+                acc >>= 32;
+                acc_bits -= 32;
+            }
+        }
+        if (acc_bits)
+            result.digits.push_back(static_cast<uint32_t>(acc));
+        result.negative = s[0] == '-';
+        result.trim();
+        return result;
+    }
+
+    // Binary records (see namespace serial), written through BigIntView
+    size_t serialized_size() const
+    {
+        return BigIntView(*this).serialized_size();
+    }
+
+    size_t serialize(std::span<std::byte> out) const
+    {
+        return BigIntView(*this).serialize(out);
+    }
+
+    void serialize(std::ostream &os) const
+    {
+        BigIntView(*this).serialize(os);
+    }
+
+    // Reads the record at the front of in, in either byte order; *consumed receives its size
+    static BasicBigInt deserialize(std::span<const std::byte> in, size_t *consumed = nullptr, const Alloc &alloc = Alloc())
+    {
+        bool swap;
+        serial::Header h = serial::read_header(in, swap);
+        BasicBigInt result(alloc);
+        result.digits.resize(h.limbs);
+        if (h.limbs)
+            std::memcpy(result.digits.data(), in.data() + sizeof(h), h.limbs * sizeof(uint32_t));
+        if (consumed)
+            *consumed = std::min(in.size(), serial::record_size(h.limbs));
+        result.finish_load(h, swap);
+        return result;
+    }
+
+    static BasicBigInt deserialize(std::istream &is, const Alloc &alloc = Alloc())
+    {
+        serial::Header h;
+        bool swap;
+        if (!is.read(reinterpret_cast<char *>(&h), sizeof(h)))
+            throw std::invalid_argument("BigInt::deserialize: truncated input");
+        serial::check_header(h, swap);
+        BasicBigInt result(alloc);
+        // Grown in bounded steps so a corrupt count fails on the read, not the allocation
+        constexpr size_t CHUNK = size_t(1) << 20;
+        for (size_t done = 0; done < h.limbs;)
+        {
+            size_t step = std::min<size_t>(CHUNK, h.limbs - done);
+            result.digits.resize(done + step);
+            if (!is.read(reinterpret_cast<char *>(result.digits.data() + done), static_cast<std::streamsize>(step * sizeof(uint32_t))))
+                throw std::invalid_argument("BigInt::deserialize: truncated input");
+            done += step;
+        }
+        is.ignore(static_cast<std::streamsize>(serial::record_size(h.limbs) - sizeof(h) - h.limbs * sizeof(uint32_t)));
+        result.finish_load(h, swap);
+        return result;
+    }
+
+    // Compact wire encoding (see namespace serial)
+    size_t compact_size() const
+    {
+        return BigIntView(*this).compact_size();
+    }
+
+    size_t encode_compact(std::span<std::byte> out) const
+    {
+        return BigIntView(*this).encode_compact(out);
+    }
+
+    // Decodes the value at the front of in; *consumed receives its length
+    static BasicBigInt decode_compact(std::span<const std::byte> in, size_t *consumed = nullptr, const Alloc &alloc = Alloc())
+    {
+        BasicBigInt result(alloc);
+        size_t n = result.read_compact(in.data(), in.data() + in.size());
+        if (consumed)
+            *consumed = n;
+        return result;
+    }
+
+    // All values back to back in one buffer, sized in a first pass
+    static std::vector<std::byte> encode_compact_batch(std::span<const BasicBigInt> values)
+    {
+        size_t total = 0;
+        for (const BasicBigInt &x : values)
+            total += x.compact_size();
+        // Slack so every varint can take the 8-byte store of the BMI2 kernel
+        std::vector<std::byte> out(total + 8);
+        std::byte *p = out.data();
+        for (const BasicBigInt &x : values)
+            p += serial::encode_compact(p, x.digits, x.negative, true);
+        out.resize(total);
+        return out;
+    }
+
+    // Decodes values until in is exhausted
+    static std::vector<BasicBigInt> decode_compact_batch(std::span<const std::byte> in, const Alloc &alloc = Alloc())
+    {
+        std::vector<BasicBigInt> result;
+        const std::byte *p = in.data();
+        const std::byte *end = p + in.size();
+        while (p < end)
+        {
+            result.emplace_back(alloc);
+            p += result.back().read_compact(p, end);
+        }
+        return result;
+    }
+
+    // Input and Output; std::hex and std::oct select base 16 and 8, std::showbase and
+    // std::uppercase are honoured on output and a 0x prefix is accepted on hex input
+    friend std::istream &operator>>(std::istream &is, BasicBigInt &bigint)
+    {
+        std::string s;
+        if (!(is >> s))
+            return is;
+        int base = stream_base(is.flags());
+        size_t sign = !s.empty() && (s[0] == '-' || s[0] == '+') ? 1 : 0;
+        if (base == 16 && s.size() > sign + 2 && s[sign] == '0' && (s[sign + 1] == 'x' || s[sign + 1] == 'X'))
+            s.erase(sign, 2);
+        try
+        {
+            bigint = from_string(s, base);
+        }
+        catch (const std::invalid_argument &)
+        {
+            is.setstate(std::ios_base::failbit);
+        }
+        return is;
+    }
+
+    friend std::ostream &operator<<(std::ostream &os, const BasicBigInt &bigint)
+    {
+        std::ios_base::fmtflags flags = os.flags();
+        int base = stream_base(flags);
+        std::string s = bigint.to_string(base, (flags & std::ios_base::uppercase) != 0);
+        if ((flags & std::ios_base::showbase) && base != 10 && !bigint.isZero())
+        {
+            size_t sign = bigint.negative ? 1 : 0;
+            s.insert(sign, base == 16 ? ((flags & std::ios_base::uppercase) ? "0X" : "0x") : "0");
+        }
+        os << s;
+        return os;
+    }
+
+    // Shift operators
+    BasicBigInt operator<<(int shift) const
+    {
+        if (isZero() || shift == 0)
+            return BasicBigInt(*this, get_allocator());
+        size_t word_shift = shift / 32;
+        unsigned bit_shift = shift % 32;
+        size_t n = digits.size();
+        BasicBigInt result(get_allocator());
+        result.negative = negative;
+        result.digits.resize(n + word_shift + 1);
+        result.digits[n + word_shift] = limb_ops::lshift(result.digits.data() + word_shift, digits.data(), n, bit_shift);
+        result.trim();
+        return result;
+    }
+
+    BasicBigInt operator>>(int shift) const
+    {
+        if (isZero() || shift == 0)
+            return BasicBigInt(*this, get_allocator());
+        size_t word_shift = shift / 32;
+        unsigned bit_shift = shift % 32;
+        if (word_shift >= digits.size())
+        {
+            return BasicBigInt(get_allocator());
+        }
+        BasicBigInt result(get_allocator());
+        result.negative = negative;
+        result.digits.resize(digits.size() - word_shift);
+        limb_ops::rshift(result.digits.data(), digits.data() + word_shift, result.digits.size(), bit_shift);
+        result.trim();
+        return result;
+    }
+
+    // Shift-assignment operators, done in place without a temporary
+    BasicBigInt &operator<<=(int shift)
+    {
+        if (isZero() || shift == 0)
+            return *this;
+        size_t word_shift = shift / 32;
+        unsigned bit_shift = shift % 32;
+        size_t n = digits.size();
+        digits.resize(n + word_shift + 1);
+        digits[n + word_shift] = limb_ops::lshift(digits.data() + word_shift, digits.data(), n, bit_shift);
+        std::fill(digits.begin(), digits.begin() + word_shift, 0u);
+        trim();
+        return *this;
+    }
+
+    BasicBigInt &operator>>=(int shift)
+    {
+        if (isZero() || shift == 0)
+            return *this;
+        size_t word_shift = shift / 32;
+        unsigned bit_shift = shift % 32;
+        if (word_shift >= digits.size())
+        {
+            digits.clear();
+            negative = false;
+            return *this;
+        }
+        size_t n = digits.size() - word_shift;
+        limb_ops::rshift(digits.data(), digits.data() + word_shift, n, bit_shift);
+        digits.resize(n);
+        trim();
+        return *this;
+    }
+
+    // floor(x / 2^shift), the two's-complement right shift: fdiv_q_2exp(-5, 1) == -3
+    // and it agrees with (x & ~(2^shift - 1)) / 2^shift, where >> gives -2
+    static BasicBigInt fdiv_q_2exp(const BasicBigInt &x, size_t shift)
+    {
+        size_t word_shift = shift / 32;
+        BasicBigInt result(x.get_allocator());
+        if (word_shift < x.digits.size())
+        {
+            result.negative = x.negative;
+            result.digits.resize(x.digits.size() - word_shift);
+            limb_ops::rshift(result.digits.data(), x.digits.data() + word_shift, result.digits.size(), shift % 32);
+            result.trim();
+        }
+        // A negative value that loses set bits rounds one further from zero
+        if (x.negative && x.countr_zero() < shift)
+        {
+            result.add_pow2_magnitude(0);
+            result.negative = true;
+        }
+        return result;
+    }
+
+    // Rvalue overloads: a dying operand is updated in place and returned, so chains
+    // like a + b + c allocate once instead of once per operator. A right-hand rvalue
+    // is only reused when its allocator matches the left operand's, which the result
+    // is defined to carry.
+    friend BasicBigInt operator+(BasicBigInt &&a, const BasicBigInt &b)
+    {
+        a += b;
+        return std::move(a);
+    }
+
+    friend BasicBigInt operator+(const BasicBigInt &a, BasicBigInt &&b)
+    {
+        if (!a.same_allocator(b))
+            return a.operator+(b);
+        b += a;
+        return std::move(b);
+    }
+
+    friend BasicBigInt operator+(BasicBigInt &&a, BasicBigInt &&b)
+    {
+        return std::move(a) + static_cast<const BasicBigInt &>(b);
+    }
+
+    friend BasicBigInt operator-(BasicBigInt &&a, const BasicBigInt &b)
+    {
+        a -= b;
+        return std::move(a);
+    }
+
+    // a - b == -(b - a)
+    friend BasicBigInt operator-(const BasicBigInt &a, BasicBigInt &&b)
+    {
+        if (!a.same_allocator(b))
+            return a.operator-(b);
+        b -= a;
+        if (!b.isZero())
+            b.negative = !b.negative;
+        return std::move(b);
+    }
+
+    friend BasicBigInt operator-(BasicBigInt &&a, BasicBigInt &&b)
+    {
+        return std::move(a) - static_cast<const BasicBigInt &>(b);
+    }
+
+    friend BasicBigInt operator-(BasicBigInt &&a)
+    {
+        if (!a.isZero())
+            a.negative = !a.negative;
+        return std::move(a);
+    }
+
+    friend BasicBigInt operator*(BasicBigInt &&a, const BasicBigInt &b)
+    {
+        a *= b;
+        return std::move(a);
+    }
+
+    friend BasicBigInt operator*(const BasicBigInt &a, BasicBigInt &&b)
+    {
+        if (!a.same_allocator(b))
+            return a.operator*(b);
+        b *= a;
+        return std::move(b);
+    }
+
+    friend BasicBigInt operator*(BasicBigInt &&a, BasicBigInt &&b)
+    {
+        return std::move(a) * static_cast<const BasicBigInt &>(b);
+    }
+
+    friend BasicBigInt operator&(BasicBigInt &&a, const BasicBigInt &b)
+    {
+        a &= b;
+        return std::move(a);
+    }
+
+    friend BasicBigInt operator&(const BasicBigInt &a, BasicBigInt &&b)
+    {
+        if (!a.same_allocator(b))
+            return a.operator&(b);
+        bitwise<limb_ops::BIT_AND>(b, a, b);
+        return std::move(b);
+    }
+
+    friend BasicBigInt operator&(BasicBigInt &&a, BasicBigInt &&b)
+    {
+        return std::move(a) & static_cast<const BasicBigInt &>(b);
+    }
+
+    friend BasicBigInt operator|(BasicBigInt &&a, const BasicBigInt &b)
+    {
+        a |= b;
+        return std::move(a);
+    }
+
+    friend BasicBigInt operator|(const BasicBigInt &a, BasicBigInt &&b)
+    {
+        if (!a.same_allocator(b))
+            return a.operator|(b);
+        bitwise<limb_ops::BIT_OR>(b, a, b);
+        return std::move(b);
+    }
+
+    friend BasicBigInt operator|(BasicBigInt &&a, BasicBigInt &&b)
+    {
+        return std::move(a) | static_cast<const BasicBigInt &>(b);
+    }
+
+    friend BasicBigInt operator^(BasicBigInt &&a, const BasicBigInt &b)
+    {
+        a ^= b;
+        return std::move(a);
+    }
+
+    friend BasicBigInt operator^(const BasicBigInt &a, BasicBigInt &&b)
+    {
+        if (!a.same_allocator(b))
+            return a.operator^(b);
+        bitwise<limb_ops::BIT_XOR>(b, a, b);
+        return std::move(b);
+    }
+
+    friend BasicBigInt operator^(BasicBigInt &&a, BasicBigInt &&b)
+    {
+        return std::move(a) ^ static_cast<const BasicBigInt &>(b);
+    }
+
+    friend BasicBigInt operator<<(BasicBigInt &&a, int shift)
+    {
+        a <<= shift;
+        return std::move(a);
+    }
+
+    friend BasicBigInt operator>>(BasicBigInt &&a, int shift)
+    {
+        a >>= shift;
+        return std::move(a);
+    }
+
+    // View operands on the right; the result keeps this number's allocator. Operators
+    // with a view on the left are defined after BigInt and return a BigInt.
+    template <std::same_as<BigIntView> V>
+    BasicBigInt operator+(V other) const
+    {
+        return sum_of(*this, other, false, get_allocator());
+    }
+
+    template <std::same_as<BigIntView> V>
+    BasicBigInt operator-(V other) const
+    {
+        return sum_of(*this, other, true, get_allocator());
+    }
+
+    template <std::same_as<BigIntView> V>
+    BasicBigInt operator*(V other) const
+    {
+        return product_of(*this, other, get_allocator());
+    }
+
+    template <std::same_as<BigIntView> V>
+    BasicBigInt operator/(V other) const
+    {
+        BasicBigInt quotient(get_allocator()), remainder(get_allocator());
+        divmod(*this, other, quotient, remainder);
+        return quotient;
+    }
+
+    template <std::same_as<BigIntView> V>
+    BasicBigInt operator%(V other) const
+    {
+        BasicBigInt quotient(get_allocator()), remainder(get_allocator());
+        divmod(*this, other, quotient, remainder);
+        return remainder;
+    }
+
+    template <std::same_as<BigIntView> V>
+    BasicBigInt operator&(V other) const
+    {
+        BasicBigInt result(get_allocator());
+        bitwise<limb_ops::BIT_AND>(result, *this, other);
+        return result;
+    }
+
+    template <std::same_as<BigIntView> V>
+    BasicBigInt operator|(V other) const
+    {
+        BasicBigInt result(get_allocator());
+        bitwise<limb_ops::BIT_OR>(result, *this, other);
+        return result;
+    }
+
+    template <std::same_as<BigIntView> V>
+    BasicBigInt operator^(V other) const
+    {
+        BasicBigInt result(get_allocator());
+        bitwise<limb_ops::BIT_XOR>(result, *this, other);
+        return result;
+    }
+
+    template <std::same_as<BigIntView> V>
+    BasicBigInt &operator+=(V other)
+    {
+        add_signed(other, other.negative);
+        return *this;
+    }
+
+    template <std::same_as<BigIntView> V>
+    BasicBigInt &operator-=(V other)
+    {
+        add_signed(other, !other.negative);
+        return *this;
+    }
+
+    template <std::same_as<BigIntView> V>
+    BasicBigInt &operator*=(V other)
+    {
+        multiply_by(other);
+        return *this;
+    }
+
+    template <std::same_as<BigIntView> V>
+    BasicBigInt &operator&=(V other)
+    {
+        bitwise<limb_ops::BIT_AND>(*this, *this, other);
+        return *this;
+    }
+
+    template <std::same_as<BigIntView> V>
+    BasicBigInt &operator|=(V other)
+    {
+        bitwise<limb_ops::BIT_OR>(*this, *this, other);
+        return *this;
+    }
+
+    template <std::same_as<BigIntView> V>
+    BasicBigInt &operator^=(V other)
+    {
+        bitwise<limb_ops::BIT_XOR>(*this, *this, other);
+        return *this;
+    }
+
+    template <std::same_as<BigIntView> V>
+    bool operator<(V other) const
+    {
+        return compare(*this, other) < 0;
+    }
+
+    template <std::same_as<BigIntView> V>
+    bool operator>=(V other) const
+    {
+        return compare(*this, other) >= 0;
+    }
+
+    template <std::same_as<BigIntView> V>
+    bool operator==(V other) const
+    {
+        return negative == other.negative && std::ranges::equal(digits, other.limbs);
+    }
+
+    friend BasicBigInt<> operator+(BigIntView a, BigIntView b);
+    friend BasicBigInt<> operator-(BigIntView a, BigIntView b);
+    friend BasicBigInt<> operator*(BigIntView a, BigIntView b);
+    friend BasicBigInt<> operator/(BigIntView a, BigIntView b);
+    friend BasicBigInt<> operator%(BigIntView a, BigIntView b);
+    friend BasicBigInt<> operator&(BigIntView a, BigIntView b);
+    friend BasicBigInt<> operator|(BigIntView a, BigIntView b);
+    friend BasicBigInt<> operator^(BigIntView a, BigIntView b);
+
+    // Bit-level queries. bit_length, popcount, hamming_distance and countr_zero look at
+    // the magnitude; test_bit, set_bit, clear_bit and scan1 use the same infinite two's
+    // complement view as the bitwise operators.
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    // Number of bits in |x|, 0 for zero
+    size_t bit_length() const
+    {
+        if (digits.empty())
+            return 0;
+        return 32 * digits.size() - __builtin_clz(digits.back());
+    }
+
+    // Number of set bits in |x|
+    size_t popcount() const
+    {
+        return limb_ops::popcount(digits.data(), digits.size());
+    }
+
+    // Number of differing bits between |x| and |other|
+    size_t hamming_distance(const BasicBigInt &other) const
+    {
+        const BasicBigInt &longer = digits.size() >= other.digits.size() ? *this : other;
+        const BasicBigInt &shorter = digits.size() >= other.digits.size() ? other : *this;
+        size_t n = shorter.digits.size();
+        return limb_ops::hamming(longer.digits.data(), shorter.digits.data(), n) +
+               limb_ops::popcount(longer.digits.data() + n, longer.digits.size() - n);
+    }
+
+    // Number of trailing zero bits (identical for x and -x), 0 for zero
+    size_t countr_zero() const
+    {
+        if (digits.empty())
+            return 0;
+        return limb_ops::scan1(digits.data(), digits.size(), 0);
+    }
+
+    bool test_bit(size_t n) const
+    {
+        size_t w = n / 32;
+        bool bit = w < digits.size() && ((digits[w] >> (n % 32)) & 1);
+        if (!negative)
+            return bit;
+        // -m is ~(m - 1): zeros below the lowest set bit of m, that bit, then ~m
+        size_t t = countr_zero();
+        return n == t || (n > t && !bit);
+    }
+
+    BasicBigInt &set_bit(size_t n)
+    {
+        if (test_bit(n))
+            return *this;
+        if (negative)
+            sub_pow2_magnitude(n);
+        else
+            add_pow2_magnitude(n);
+        return *this;
+    }
+
+    BasicBigInt &clear_bit(size_t n)
+    {
+        if (!test_bit(n))
+            return *this;
+        if (negative)
+            add_pow2_magnitude(n);
+        else
+            sub_pow2_magnitude(n);
+        return *this;
+    }
+
+    // Index of the lowest set bit at or above `from`, or npos for a non-negative value without one
+    size_t scan1(size_t from) const
+    {
+        size_t n = digits.size();
+        if (!negative)
+        {
+            size_t i = limb_ops::scan1(digits.data(), n, from);
+            return i == n * 32 ? npos : i;
+        }
+        size_t t = countr_zero();
+        if (from <= t)
+            return t;
+        return limb_ops::scan0(digits.data(), n, from);
+    }
+
+    // Comparison operators
+    bool operator<(const BasicBigInt &other) const
+    {
+        return compare(*this, other) < 0;
+    }
+
+    bool operator>=(const BasicBigInt &other) const
+    {
+        return !(*this < other);
+    }
+
+    // Equality operator
+    bool operator==(const BasicBigInt &other) const
+    {
+        return negative == other.negative && digits == other.digits;
+    }
+
+    // Sign of a - b
+    static int compare(BigIntView a, BigIntView b)
+    {
+        if (a.negative != b.negative)
+            return a.negative ? -1 : 1;
+        int c = cmp_magnitude(a, b);
+        return a.negative ? -c : c;
+    }
+
+    // Greatest common divisor, always non-negative; gcd(0, 0) == 0
+    static BasicBigInt gcd(const BasicBigInt &a, const BasicBigInt &b)
+    {
+        BasicBigInt u = a.abs();
+        BasicBigInt v = b.abs();
+        if (u < v)
+            std::swap(u, v);
+        hgcd_reduce_gcd(u, v, nullptr);
+        lehmer_gcd(u, v, nullptr);
+        return u;
+    }
+
+    // Least common multiple, always non-negative; zero if either argument is zero
+    static BasicBigInt lcm(const BasicBigInt &a, const BasicBigInt &b)
+    {
+        if (a.isZero() || b.isZero())
+            return BasicBigInt(a.get_allocator());
+        return (a.abs() / gcd(a, b)) * b.abs();
+    }
+
+    // Returns g = gcd(a, b) and sets x, y such that a*x + b*y == g
+    static BasicBigInt extended_gcd(const BasicBigInt &a, const BasicBigInt &b, BasicBigInt &x, BasicBigInt &y)
+    {
+        BasicBigInt u = a.abs();
+        BasicBigInt v = b.abs();
+        bool swapped = u < v;
+        if (swapped)
+            std::swap(u, v);
+        BasicBigInt cf[4] = {BasicBigInt(1), BasicBigInt(0), BasicBigInt(0), BasicBigInt(1)};
+        hgcd_reduce_gcd(u, v, cf);
+        lehmer_gcd(u, v, cf);
+        x = swapped ? cf[2] : cf[0];
+        y = swapped ? cf[0] : cf[2];
+        if (a.negative)
+            x = -x;
+        if (b.negative)
+            y = -y;
+        return u;
+    }
+
+    // Inverse of a modulo m > 0, in [0, m); throws std::domain_error if gcd(a, m) != 1
+    static BasicBigInt modinv(const BasicBigInt &a, const BasicBigInt &m)
+    {
+        check_modulus(m, "BigInt::modinv");
+        BasicBigInt x(a.get_allocator()), y(a.get_allocator());
+        if (!(extended_gcd(mod_floor(a, m), m, x, y) == BasicBigInt(1)))
+            throw std::domain_error("BigInt::modinv: argument not invertible");
+        return mod_floor(x, m);
+    }
+
+    // Inverses of every element modulo m with a single modinv (Montgomery's trick):
+    // prefix products are inverted once and unwound with two multiplications per
+    // element. Throws std::domain_error if any element shares a factor with m.
+    static std::vector<BasicBigInt> batch_modinv(std::span<const BasicBigInt> values, const BasicBigInt &m)
+    {
+        check_modulus(m, "BigInt::batch_modinv");
+        size_t n = values.size();
+        std::vector<BasicBigInt> result;
+        result.reserve(n);
+        for (size_t i = 0; i < n; ++i)
+            result.emplace_back(m.get_allocator());
+        if (n == 0)
+            return result;
+        // result[i] holds the prefix product values[0..i] mod m until the backward pass
+        BasicBigInt acc(1);
+        for (size_t i = 0; i < n; ++i)
+        {
+            acc = mod_floor(acc * values[i], m);
+            result[i] = acc;
+        }
+        BasicBigInt x, y;
+        if (!(extended_gcd(acc, m, x, y) == BasicBigInt(1)))
+            throw std::domain_error("BigInt::batch_modinv: element not invertible");
+        BasicBigInt inv = mod_floor(x, m);
+        for (size_t i = n; i-- > 1;)
+        {
+            result[i] = mod_floor(inv * result[i - 1], m);
+            inv = mod_floor(inv * values[i], m);
+        }
+        result[0] = std::move(inv);
+        return result;
+    }
+
+    // floor(sqrt(x)) for x >= 0; throws std::domain_error for negative x
+    static BasicBigInt isqrt(const BasicBigInt &x)
+    {
+        BasicBigInt r(x.get_allocator());
+        return isqrt_rem(x, r);
+    }
+
+    // Returns s = floor(sqrt(x)) and sets rem = x - s*s
+    static BasicBigInt isqrt_rem(const BasicBigInt &x, BasicBigInt &rem)
+    {
+        if (x.negative)
+            throw std::domain_error("BigInt::isqrt: negative argument");
+        BasicBigInt s(x.get_allocator());
+        sqrt_rem(x, s, rem);
+        return s;
+    }
+
+    // Residues modulo 64 and eleven small odd moduli reject almost every non-square
+    // before the square root is taken
+    static bool is_perfect_square(const BasicBigInt &x)
+    {
+        if (x.negative)
+            return false;
+        if (x.isZero())
+            return true;
+        constexpr uint64_t QR64 = limb_ops::square_residues(64);
+        if (!((QR64 >> (x.digits[0] & 63)) & 1))
+            return false;
+        // 63 * 11 * 17 * 19 * 23 and 29 * 31 * 37 * 41 * 43 both fit a limb
+        static constexpr unsigned MODULI[2][5] = {{63, 11, 17, 19, 23}, {29, 31, 37, 41, 43}};
+        static constexpr uint64_t RESIDUES[2][5] = {
+            {limb_ops::square_residues(63), limb_ops::square_residues(11), limb_ops::square_residues(17),
+             limb_ops::square_residues(19), limb_ops::square_residues(23)},
+            {limb_ops::square_residues(29), limb_ops::square_residues(31), limb_ops::square_residues(37),
+             limb_ops::square_residues(41), limb_ops::square_residues(43)}};
+        for (int g = 0; g < 2; ++g)
+        {
+            uint32_t product = 1;
+            for (unsigned m : MODULI[g])
+                product *= m;
+            uint32_t r = limb_ops::mod_1(x.digits.data(), x.digits.size(), product);
+            for (int j = 0; j < 5; ++j)
+            {
+                if (!((RESIDUES[g][j] >> (r % MODULI[g][j])) & 1))
+                    return false;
+            }
+        }
+        BasicBigInt rem;
+        isqrt_rem(x, rem);
+        return rem.isZero();
+    }
+
+    // floor of the k-th root of |x|, negated for negative x (truncation toward zero).
+    // Throws std::invalid_argument for k == 0 and std::domain_error for an even root
+    // of a negative number.
+    static BasicBigInt iroot(const BasicBigInt &x, unsigned k)
+    {
+        if (k == 0)
+            throw std::invalid_argument("BigInt::iroot: zero exponent");
+        if (x.negative && k % 2 == 0)
+            throw std::domain_error("BigInt::iroot: even root of negative argument");
+        BasicBigInt r(x.get_allocator());
+        r = root_magnitude(x.abs(), k);
+        r.negative = x.negative && !r.isZero();
+        return r;
+    }
+
+    // True if x == y^k for some integer y and k >= 2 (0, 1 and -1 included). Each
+    // prime exponent p is first sieved: it must divide the power of two in x, and x
+    // must be a p-th power residue modulo a few primes q = 1 (mod p), where only
+    // one unit in p qualifies. Survivors are confirmed with an exact iroot.
+    static bool is_perfect_power(const BasicBigInt &x)
+    {
+        BasicBigInt m = x.abs();
+        if (m.digits.size() <= 1 && m.low_u64() <= 1)
+            return true;
+        if (!x.negative && is_perfect_square(m))
+            return true;
+        size_t len = m.bit_length();
+        size_t twos = m.countr_zero();
+        if (twos == 1)
+            return false;
+        // Odd primes p with 2^p <= |x|
+        std::vector<bool> composite(len + 1);
+        for (size_t p = 3; p < len; p += 2)
+        {
+            if (composite[p])
+                continue;
+            for (size_t j = p * p; j <= len; j += 2 * p)
+                composite[j] = true;
+            if (twos != 0 && twos % p != 0)
+                continue;
+            if (!power_residue_sieve(m, static_cast<uint32_t>(p)))
+                continue;
+            BasicBigInt r = root_magnitude(m, static_cast<unsigned>(p));
+            if (pow_uint(r, p) == m)
+                return true;
+        }
+        return false;
+    }
+
+    // Baillie-PSW: trial division by the odd primes below 1024 (one pass over x for all
+    // of them), a strong Fermat test to base 2 and a strong Lucas test with Selfridge's
+    // parameters, followed by `rounds` Miller-Rabin tests to pseudo-random bases.
+    // No composite is known to pass BPSW alone; it is exact below 2^64.
+    static bool is_probable_prime(const BasicBigInt &x, int rounds = 0)
+    {
+        if (x.negative || x.isZero())
+            return false;
+        const limb_ops::SmallPrimes &sp = limb_ops::small_primes();
+        if (x.digits.size() == 1 && x.digits[0] <= sp.primes.back())
+        {
+            uint32_t v = x.digits[0];
+            return v == 2 || std::binary_search(sp.primes.begin(), sp.primes.end(), v);
+        }
+        if ((x.digits[0] & 1) == 0)
+            return false;
+        std::vector<uint32_t> residues = small_prime_residues(x);
+        if (std::find(residues.begin(), residues.end(), 0u) != residues.end())
+            return false;
+        if (x.digits.size() == 1 && uint64_t(x.digits[0]) < uint64_t(sp.primes.back()) * sp.primes.back())
+            return true;
+        return bpsw(x, rounds);
+    }
+
+    // Smallest prime greater than x. Candidates are sieved by updating the residues of
+    // the first one, so only those free of small factors reach the BPSW test.
+    static BasicBigInt next_prime(const BasicBigInt &x, int rounds = 0)
+    {
+        const limb_ops::SmallPrimes &sp = limb_ops::small_primes();
+        if (x < BasicBigInt(2))
+            return BasicBigInt(2, x.get_allocator());
+        BasicBigInt start = x + BasicBigInt(1);
+        if (start.digits.size() == 1 && start.digits[0] <= sp.primes.back())
+        {
+            uint32_t v = start.digits[0];
+            if (v <= 3)
+                return BasicBigInt(v, x.get_allocator());
+            return BasicBigInt(*std::lower_bound(sp.primes.begin(), sp.primes.end(), v), x.get_allocator());
+        }
+        if ((start.digits[0] & 1) == 0)
+            start = start + BasicBigInt(1);
+        std::vector<uint32_t> residues = small_prime_residues(start);
+        for (uint64_t delta = 0;; delta += 2)
+        {
+            bool sieved = false;
+            for (size_t i = 0; i < residues.size() && !sieved; ++i)
+                sieved = (residues[i] + delta) % sp.primes[i] == 0;
+            if (sieved)
+                continue;
+            BasicBigInt candidate = start + BasicBigInt(delta);
+            if (bpsw(candidate, rounds))
+                return candidate;
+        }
+    }
+
+    // n! by the prime-swing recursion n! = ((n/2)!)^2 * swing(n), where swing(n) is a
+    // product of prime powers p^e <= n read off the sieve; odd parts only, with the
+    // n - popcount(n) factors of two shifted in at the end
+    static BasicBigInt factorial(uint32_t n, const Alloc &alloc = Alloc())
+    {
+        std::vector<uint32_t> primes = limb_ops::primes_up_to(n);
+        BasicBigInt result(alloc);
+        result = odd_factorial(n, primes) << static_cast<int>(n - __builtin_popcount(n));
+        return result;
+    }
+
+    // n choose k; zero for k > n. Small k multiplies out the falling factorial,
+    // otherwise the prime powers come from Kummer's theorem: the exponent of p is the
+    // number of carries when adding k and n - k in base p.
+    static BasicBigInt binomial(uint32_t n, uint32_t k, const Alloc &alloc = Alloc())
+    {
+        if (k > n)
+            return BasicBigInt(alloc);
+        k = std::min(k, n - k);
+        if (k < 32)
+        {
+            std::vector<uint32_t> terms;
+            for (uint32_t i = 0; i < k; ++i)
+                terms.push_back(n - i);
+            return word_product(terms, alloc) / factorial(k);
+        }
+        std::vector<uint32_t> factors;
+        for (uint32_t p : limb_ops::primes_up_to(n))
+        {
+            uint32_t power = 1;
+            for (uint64_t q = p; q <= n; q *= p)
+            {
+                if (n / q - k / q - (n - k) / q)
+                    power *= p;
+            }
+            if (power > 1)
+                factors.push_back(power);
+        }
+        return word_product(factors, alloc);
+    }
+
+    // Product of all primes <= n
+    static BasicBigInt primorial(uint32_t n, const Alloc &alloc = Alloc())
+    {
+        return word_product(limb_ops::primes_up_to(n), alloc);
+    }
+
+    // Product of all values (1 for none) through a balanced product tree, so that the
+    // large multiplications see operands of similar size. With parallel set, the top
+    // levels of the tree are split across the hardware threads.
+    static BasicBigInt product(std::span<const BasicBigInt> values, bool parallel = false)
+    {
+        BasicBigInt result(values.empty() ? Alloc() : values[0].get_allocator());
+        result = product_tree(values, parallel_depth(parallel));
+        return result;
+    }
+
+    // Sum of a[i] * b[i], accumulated into one number sized once up front
+    static BasicBigInt dot(std::span<const BasicBigInt> a, std::span<const BasicBigInt> b)
+    {
+        if (a.size() != b.size())
+            throw std::invalid_argument("BigInt::dot: length mismatch");
+        BasicBigInt result(a.empty() ? Alloc() : a[0].get_allocator());
+        size_t bound = 0;
+        for (size_t i = 0; i < a.size(); ++i)
+            bound = std::max(bound, a[i].digits.size() + b[i].digits.size());
+        result.digits.reserve(bound + 2);
+        for (size_t i = 0; i < a.size(); ++i)
+            result.add_product(a[i], b[i], false);
+        return result;
+    }
+
+    // x % m for every modulus (sign of x, as with operator%). The moduli are multiplied
+    // up a product tree and x is reduced back down it, each remainder taken from the
+    // parent's, so the big divisions happen near the root only once.
+    static std::vector<BasicBigInt> remainder_tree(const BasicBigInt &x, std::span<const BasicBigInt> moduli, bool parallel = false)
+    {
+        std::vector<BasicBigInt> result;
+        result.reserve(moduli.size());
+        for (size_t i = 0; i < moduli.size(); ++i)
+            result.emplace_back(x.get_allocator());
+        if (moduli.empty())
+            return result;
+        int depth = parallel_depth(parallel);
+        std::vector<BasicBigInt> nodes(4 * moduli.size());
+        build_product_nodes(nodes, 0, moduli, depth);
+        descend_remainders(nodes, 0, x, result.data(), moduli.size(), depth);
+        return result;
+    }
+
+    // Fibonacci number F(n), F(0) = 0, F(1) = 1
+    static BasicBigInt fibonacci(uint64_t n, const Alloc &alloc = Alloc())
+    {
+        BasicBigInt f(alloc), f_prev(alloc);
+        fibonacci_pair(n, f, f_prev);
+        return f;
+    }
+
+    // Lucas number L(n) = F(n) + 2F(n-1), L(0) = 2, L(1) = 1
+    static BasicBigInt lucas(uint64_t n, const Alloc &alloc = Alloc())
+    {
+        BasicBigInt f(alloc), f_prev(alloc);
+        fibonacci_pair(n, f, f_prev);
+        f_prev <<= 1;
+        return f + f_prev;
+    }
+
+private:
+    // Cofactors cf[0..3] = {s0, s1, t0, t1} track a = s0*A + t0*B and b = s1*A + t1*B
+    // against the original GCD inputs A, B.
+
+    // (a, b) <- (A*a - B*b, D*b - C*a)
+    static void cofactors_apply(BasicBigInt *cf, const BasicBigInt &A, const BasicBigInt &B, const BasicBigInt &C, const BasicBigInt &D)
+    {
+        for (int i = 0; i < 4; i += 2)
+        {
+            BasicBigInt u = cf[i] * A - cf[i + 1] * B;
+            cf[i + 1] = cf[i + 1] * D - cf[i] * C;
+            cf[i] = std::move(u);
+        }
+    }
+
+    // (a, b) <- (b, a - q*b)
+    static void cofactors_euclid(BasicBigInt *cf, const BasicBigInt &q)
+    {
+        for (int i = 0; i < 4; i += 2)
+        {
+            BasicBigInt u = cf[i] - q * cf[i + 1];
+            cf[i] = std::move(cf[i + 1]);
+            cf[i + 1] = std::move(u);
+        }
+    }
+
+    // Lehmer's GCD on a >= b >= 0, leaving the gcd in a. While a spans more than two
+    // limbs, the top 62 bits of a and the matching bits of b drive a single-precision
+    // cosequence (Collins' stopping condition) whose matrix is then applied to the full
+    // numbers in one pass; if no quotient can be certified a full division step is taken.
+    // The last two limbs finish on machine words, with Stein's binary GCD when no
+    // cofactors are requested.
+    static void lehmer_gcd(BasicBigInt &a, BasicBigInt &b, BasicBigInt *cf)
+    {
+        while (a.digits.size() > 2)
+        {
+            if (b.isZero())
+                return;
+            size_t pos = a.bit_length() - 62;
+            // Signed so that an overshooting quotient shows up as t < 0 and stops the loop
+            int64_t x = static_cast<int64_t>(limb_ops::extract_bits(a.digits.data(), a.digits.size(), pos, 62));
+            int64_t y = static_cast<int64_t>(limb_ops::extract_bits(b.digits.data(), b.digits.size(), pos, 62));
+            int64_t A = 1, B = 0, C = 0, D = 1;
+            size_t k = 0;
+            for (;; ++k)
+            {
+                if (y == C)
+                    break;
+                int64_t q = (x + (A - 1)) / (y - C);
+                int64_t s = B + q * D;
+                int64_t t = x - q * y;
+                if (s > t)
+                    break;
+                x = y;
+                y = t;
+                t = A + q * C;
+                A = D;
+                B = C;
+                C = s;
+                D = t;
+            }
+            if (k == 0)
+            {
+                BasicBigInt q, r;
+                divmod(a, b, q, r);
+                if (cf)
+                    cofactors_euclid(cf, q);
+                a = std::move(b);
+                b = std::move(r);
+                continue;
+            }
+            // An odd number of steps leaves the matrix with the opposite sign pattern
+            if (k & 1)
+            {
+                std::swap(A, B);
+                A = -A;
+                B = -B;
+                std::swap(C, D);
+                C = -C;
+                D = -D;
+            }
+            size_t n = a.digits.size();
+            b.digits.resize(n);
+            limb_ops::lehmer_update(a.digits.data(), b.digits.data(), n, A, B, C, D);
+            a.trim();
+            b.trim();
+            if (cf)
+                cofactors_apply(cf, BasicBigInt(A), BasicBigInt(B), BasicBigInt(C), BasicBigInt(D));
+        }
+        uint64_t x = a.low_u64();
+        uint64_t y = b.low_u64();
+        if (!cf)
+        {
+            a = BasicBigInt(limb_ops::gcd_u64(x, y));
+            b = BasicBigInt(0);
+            return;
+        }
+        while (y != 0)
+        {
+            uint64_t q = x / y;
+            uint64_t r = x - q * y;
+            cofactors_euclid(cf, BasicBigInt(q));
+            x = y;
+            y = r;
+        }
+        a = BasicBigInt(x);
+        b = BasicBigInt(0);
+    }
+
+    // Subquadratic GCD (Moller's half-GCD, following GMP's mpn_hgcd). A hgcd matrix
+    // M = {u00, u01, u10, u11} has non-negative entries, det 1, and relates the inputs
+    // to the reduced pair by (a; b) = M (a'; b').
+
+    // Sizes (in limbs) above which the recursion beats plain Lehmer steps. Cofactor
+    // updates make Lehmer far more expensive, so extended_gcd switches much earlier.
+    static constexpr size_t HGCD_THRESHOLD = 100;
+    static constexpr size_t GCD_DC_THRESHOLD = 4000;
+    static constexpr size_t GCDEXT_DC_THRESHOLD = 300;
+
+    static size_t limb_span(const BasicBigInt &a, const BasicBigInt &b)
+    {
+        return std::max(a.digits.size(), b.digits.size());
+    }
+
+    static uint32_t limb_at(const BasicBigInt &a, size_t i)
+    {
+        return i < a.digits.size() ? a.digits[i] : 0;
+    }
+
+    // Limbs [from, to) of the magnitude as a non-negative BigInt
+    static BasicBigInt limb_slice(const BasicBigInt &a, size_t from, size_t to)
+    {
+        BasicBigInt r(a.get_allocator());
+        to = std::min(to, a.digits.size());
+        if (from < to)
+            r.digits.assign(a.digits.begin() + from, a.digits.begin() + to);
+        r.trim();
+        return r;
+    }
+
+    static void hgcd_identity(BasicBigInt *M)
+    {
+        M[0] = BasicBigInt(1);
+        M[1] = BasicBigInt(0);
+        M[2] = BasicBigInt(0);
+        M[3] = BasicBigInt(1);
+    }
+
+    // M <- M * M1
+    static void hgcd_matrix_mul(BasicBigInt *M, const BasicBigInt *M1)
+    {
+        for (int row = 0; row < 4; row += 2)
+        {
+            BasicBigInt c0 = M[row] * M1[0] + M[row + 1] * M1[2];
+            M[row + 1] = M[row] * M1[1] + M[row + 1] * M1[3];
+            M[row] = std::move(c0);
+        }
+    }
+
+    // M <- M * (1, q; 0, 1) for col == 1, M * (1, 0; q, 1) for col == 0
+    static void hgcd_update_q(BasicBigInt *M, const BasicBigInt &q, int col)
+    {
+        for (int row = 0; row < 4; row += 2)
+            M[row + col] = M[row + col] + q * M[row + 1 - col];
+    }
+
+    // One subtraction plus division step, only taken while both values stay above s
+    // limbs; returns the new size or 0 (with a, b and M unchanged) when no step fits
+    static size_t hgcd_subdiv_step(BasicBigInt &a, BasicBigInt &b, size_t s, BasicBigInt *M)
+    {
+        if (a == b)
+            return 0;
+        BasicBigInt *x = &a, *y = &b;
+        int col = 0;
+        if (b < a)
+        {
+            std::swap(x, y);
+            col = 1;
+        }
+        if (x->digits.size() <= s)
+            return 0;
+        *y = *y - *x;
+        if (y->digits.size() <= s || *x == *y)
+        {
+            *y = *y + *x;
+            return 0;
+        }
+        hgcd_update_q(M, BasicBigInt(1), col);
+        if (*y < *x)
+        {
+            std::swap(x, y);
+            col ^= 1;
+        }
+        BasicBigInt q, r;
+        divmod(*y, *x, q, r);
+        *y = std::move(r);
+        if (y->digits.size() <= s)
+        {
+            // Quotient one too large for the size bound, add x back
+            *y = *y + *x;
+            q = q - BasicBigInt(1);
+        }
+        if (!q.isZero())
+            hgcd_update_q(M, q, col);
+        return limb_span(a, b);
+    }
+
+    // One Lehmer step from the top two limbs (after normalization) of a and b, applied
+    // to both values and accumulated into M; falls back to hgcd_subdiv_step
+    static size_t hgcd_step(BasicBigInt &a, BasicBigInt &b, size_t n, size_t s, BasicBigInt *M)
+    {
+        uint32_t mask = limb_at(a, n - 1) | limb_at(b, n - 1);
+        uint32_t ah, al, bh, bl;
+        if ((n == s + 1 && mask >= 4) || (n > s + 1 && (mask & 0x80000000u)))
+        {
+            ah = limb_at(a, n - 1);
+            al = limb_at(a, n - 2);
+            bh = limb_at(b, n - 1);
+            bl = limb_at(b, n - 2);
+        }
+        else if (n > s + 1)
+        {
+            int shift = __builtin_clz(mask);
+            ah = (limb_at(a, n - 1) << shift) | (limb_at(a, n - 2) >> (32 - shift));
+            al = (limb_at(a, n - 2) << shift) | (limb_at(a, n - 3) >> (32 - shift));
+            bh = (limb_at(b, n - 1) << shift) | (limb_at(b, n - 2) >> (32 - shift));
+            bl = (limb_at(b, n - 2) << shift) | (limb_at(b, n - 3) >> (32 - shift));
+        }
+        else
+        {
+            return hgcd_subdiv_step(a, b, s, M);
+        }
+        uint32_t u[4];
+        if (!limb_ops::hgcd2(ah, al, bh, bl, u))
+            return hgcd_subdiv_step(a, b, s, M);
+        BasicBigInt M1[4] = {BasicBigInt(u[0]), BasicBigInt(u[1]), BasicBigInt(u[2]), BasicBigInt(u[3])};
+        hgcd_matrix_mul(M, M1);
+        a.digits.resize(n);
+        b.digits.resize(n);
+        limb_ops::lehmer_update(a.digits.data(), b.digits.data(), n, u[3], u[1], u[2], u[0]);
+        a.trim();
+        b.trim();
+        return limb_span(a, b);
+    }
+
+    // Runs hgcd on the limbs of a and b above position p and applies the resulting M
+    // (starting as the identity) to the full values; returns the new size or 0
+    static size_t hgcd_reduce(BasicBigInt &a, BasicBigInt &b, size_t n, size_t p, BasicBigInt *M)
+    {
+        BasicBigInt ahi = limb_slice(a, p, n);
+        BasicBigInt bhi = limb_slice(b, p, n);
+        if (hgcd(ahi, bhi, M) == 0)
+            return 0;
+        BasicBigInt alo = limb_slice(a, 0, p);
+        BasicBigInt blo = limb_slice(b, 0, p);
+        ahi.digits.insert(ahi.digits.begin(), p, 0u);
+        bhi.digits.insert(bhi.digits.begin(), p, 0u);
+        // (a; b) <- M^-1 (a; b), with the high parts already reduced by hgcd
+        a = ahi + M[3] * alo - M[1] * blo;
+        b = bhi + M[0] * blo - M[2] * alo;
+        return limb_span(a, b);
+    }
+
+    // Reduces a, b (n limbs, one of them with a non-zero top limb) until both fit in
+    // just over n/2 limbs, returning the new size, or 0 if no reduction was possible
+    static size_t hgcd(BasicBigInt &a, BasicBigInt &b, BasicBigInt *M)
+    {
+        size_t n = limb_span(a, b);
+        size_t s = n / 2 + 1;
+        bool success = false;
+        if (n <= s)
+            return 0;
+        if (n >= HGCD_THRESHOLD)
+        {
+            size_t n2 = 3 * n / 4 + 1;
+            size_t nn = hgcd_reduce(a, b, n, n / 2, M);
+            if (nn)
+            {
+                n = nn;
+                success = true;
+            }
+            while (n > n2)
+            {
+                nn = hgcd_step(a, b, n, s, M);
+                if (!nn)
+                    return success ? n : 0;
+                n = nn;
+                success = true;
+            }
+            if (n > s + 2)
+            {
+                BasicBigInt M1[4];
+                hgcd_identity(M1);
+                nn = hgcd_reduce(a, b, n, 2 * s - n + 1, M1);
+                if (nn)
+                {
+                    hgcd_matrix_mul(M, M1);
+                    n = nn;
+                    success = true;
+                }
+            }
+        }
+        for (;;)
+        {
+            size_t nn = hgcd_step(a, b, n, s, M);
+            if (!nn)
+                return success ? n : 0;
+            n = nn;
+            success = true;
+        }
+    }
+
+    // Shrinks a >= b >= 0 with half-GCD steps until a is small enough for lehmer_gcd,
+    // keeping the cofactors in sync when requested
+    static void hgcd_reduce_gcd(BasicBigInt &a, BasicBigInt &b, BasicBigInt *cf)
+    {
+        size_t threshold = cf ? GCDEXT_DC_THRESHOLD : GCD_DC_THRESHOLD;
+        while (a.digits.size() >= threshold && !b.isZero())
+        {
+            size_t n = a.digits.size();
+            BasicBigInt M[4];
+            hgcd_identity(M);
+            if (hgcd_reduce(a, b, n, 2 * n / 3, M))
+            {
+                if (cf)
+                    cofactors_apply(cf, M[3], M[1], M[2], M[0]);
+            }
+            else
+            {
+                BasicBigInt q, r;
+                divmod(a, b, q, r);
+                if (cf)
+                    cofactors_euclid(cf, q);
+                a = std::move(b);
+                b = std::move(r);
+            }
+            if (a < b)
+            {
+                std::swap(a, b);
+                if (cf)
+                {
+                    std::swap(cf[0], cf[1]);
+                    std::swap(cf[2], cf[3]);
+                }
+            }
+        }
+    }
+
+    // Least non-negative residue of a modulo m > 0
+    static BasicBigInt mod_floor(const BasicBigInt &a, const BasicBigInt &m)
+    {
+        BasicBigInt r = a % m;
+        if (r.negative)
+            r = r + m;
+        return r;
+    }
+
+    static void check_modulus(const BasicBigInt &m, const char *who)
+    {
+        if (m.negative || m.isZero())
+            throw std::invalid_argument(std::string(who) + ": modulus must be positive");
+    }
+
+    // Zimmermann's Karatsuba square root on n >= 0. n is scaled by 4^t so that, with
+    // beta = 2^k, n = a3*beta^3 + a2*beta^2 + a1*beta + a0 and a3 >= beta/4; then
+    // (s', r') = sqrtrem(a3*beta + a2), (q, u) = divrem(r'*beta + a1, 2s'),
+    // s = s'*beta + q, r = u*beta + a0 - q^2, corrected once if r < 0.
+    static void sqrt_rem(const BasicBigInt &n, BasicBigInt &s, BasicBigInt &r)
+    {
+        if (n.digits.size() <= 2)
+        {
+            uint64_t v = n.low_u64();
+            uint64_t q = limb_ops::isqrt_u64(v);
+            s = BasicBigInt(q);
+            r = BasicBigInt(v - q * q);
+            return;
+        }
+        size_t len = n.bit_length();
+        int k = static_cast<int>((len + 3) / 4);
+        int t = static_cast<int>((4 * static_cast<size_t>(k) - len) / 2);
+        BasicBigInt m = n << (2 * t);
+        BasicBigInt s1, r1;
+        sqrt_rem(m >> (2 * k), s1, r1);
+        BasicBigInt q, u;
+        divmod((r1 << k) + low_bits(m >> k, k), s1 << 1, q, u);
+        s = (s1 << k) + q;
+        r = (u << k) + low_bits(m, k) - q * q;
+        if (r.negative)
+        {
+            r = r + (s << 1) - BasicBigInt(1);
+            s = s - BasicBigInt(1);
+        }
+        if (t > 0)
+        {
+            s = s >> t;
+            r = n - s * s;
+        }
+    }
+
+    // base^e by left-to-right binary powering; squarings take the sqr path
+    static BasicBigInt pow_uint(const BasicBigInt &base, uint64_t e)
+    {
+        BasicBigInt r(1);
+        for (int i = 63 - (e == 0 ? 63 : __builtin_clzll(e)); e != 0 && i >= 0; --i)
+        {
+            r = r * r;
+            if ((e >> i) & 1)
+                r = r * base;
+        }
+        return r;
+    }
+
+    // floor(m^(1/k)) for m >= 0 by Newton's iteration y <- ((k-1)y + m / y^(k-1)) / k,
+    // started above the root so that it decreases monotonically onto the floor root.
+    // Roots up to 64 bits are seeded with 2^(log2(m)/k) from the top 53 bits, rounded
+    // up past its error; longer roots with (iroot(m >> kh) + 1) << h for half of the
+    // root's h bits, which leaves only a couple of full-precision steps.
+    static BasicBigInt root_magnitude(const BasicBigInt &m, unsigned k)
+    {
+        size_t len = m.bit_length();
+        if (k == 1 || m.isZero())
+            return m;
+        if (k >= len)
+            return BasicBigInt(1);
+        if (k == 2)
+            return isqrt(m);
+        BasicBigInt y;
+        size_t root_bits = len / k;
+        if (root_bits > 64)
+        {
+            int h = static_cast<int>(root_bits / 2);
+            y = (root_magnitude(m >> (h * static_cast<int>(k)), k) + BasicBigInt(1)) << h;
+        }
+        else
+        {
+            y = root_seed(m, k);
+        }
+        BasicBigInt kk(k), k1(k - 1);
+        for (;;)
+        {
+            BasicBigInt t = (k1 * y + m / pow_uint(y, k - 1)) / kk;
+            if (!(t < y))
+                return y;
+            y = std::move(t);
+        }
+    }
+
+    // Upper bound on the k-th root of m from a floating-point estimate
+    static BasicBigInt root_seed(const BasicBigInt &m, unsigned k)
+    {
+        size_t len = m.bit_length();
+        size_t shift = len > 53 ? len - 53 : 0;
+        double top = static_cast<double>((m >> static_cast<int>(shift)).low_u64());
+        double lg = (std::log2(top) + static_cast<double>(shift)) / k;
+        double slack = 1.0 + 0x1p-30 + std::ldexp(static_cast<double>(len), -48);
+        BasicBigInt y;
+        if (lg < 62)
+        {
+            y = BasicBigInt(static_cast<uint64_t>(std::exp2(lg) * slack) + 1);
+        }
+        else
+        {
+            double whole = std::floor(lg);
+            uint64_t mantissa = static_cast<uint64_t>(std::ldexp(std::exp2(lg - whole) * slack, 52)) + 1;
+            y = BasicBigInt(mantissa) << static_cast<int>(whole - 52);
+        }
+        return y;
+    }
+
+    // False if m (> 1) provably is not a p-th power: checks m mod q for up to three
+    // primes q = 2ip + 1, where x^((q-1)/p) == 1 holds for p-th power residues only
+    static bool power_residue_sieve(const BasicBigInt &m, uint32_t p)
+    {
+        int tested = 0;
+        for (uint64_t q = 2 * uint64_t(p) + 1; tested < 3 && q < (uint64_t(1) << 32); q += 2 * p)
+        {
+            if (!limb_ops::is_prime_u32(static_cast<uint32_t>(q)))
+                continue;
+            ++tested;
+            uint32_t r = limb_ops::mod_1(m.digits.data(), m.digits.size(), static_cast<uint32_t>(q));
+            if (r != 0 && limb_ops::powmod_u32(r, (q - 1) / p, static_cast<uint32_t>(q)) != 1)
+                return false;
+        }
+        return true;
+    }
+
+    // Low k bits of the magnitude
+    static BasicBigInt low_bits(const BasicBigInt &a, size_t k)
+    {
+        BasicBigInt r = limb_slice(a, 0, (k + 31) / 32);
+        if (k % 32 != 0 && r.digits.size() == (k + 31) / 32)
+        {
+            r.digits.back() &= (uint32_t(1) << (k % 32)) - 1;
+            r.trim();
+        }
+        return r;
+    }
+
+    // Arithmetic modulo an odd n > 1 on k-limb residues kept in Montgomery form
+    // a*R mod n, R = 2^(32k)
+    struct Montgomery
+    {
+        std::vector<uint32_t> n;
+        std::vector<uint32_t> r2; // R^2 mod n, maps residues into the form
+        std::vector<uint32_t> t;
+        size_t k;
+        uint32_t ninv;
+
+        explicit Montgomery(const BasicBigInt &modulus)
+            : n(modulus.digits.begin(), modulus.digits.end()), t(modulus.digits.size() + 2), k(modulus.digits.size()),
+              ninv(limb_ops::mont_ninv(modulus.digits[0]))
+        {
+            r2 = limbs((BasicBigInt(1) << static_cast<int>(64 * k)) % modulus);
+        }
+
+        // v (0 <= v < n) zero-extended to k limbs
+        std::vector<uint32_t> limbs(const BasicBigInt &v) const
+        {
+            std::vector<uint32_t> r(v.digits.begin(), v.digits.end());
+            r.resize(k);
+            return r;
+        }
+
+        std::vector<uint32_t> to_form(const BasicBigInt &v)
+        {
+            std::vector<uint32_t> r = limbs(v);
+            mul(r, r, r2);
+            return r;
+        }
+
+        void mul(std::vector<uint32_t> &r, const std::vector<uint32_t> &a, const std::vector<uint32_t> &b)
+        {
+            limb_ops::mont_mul(r.data(), a.data(), b.data(), n.data(), k, ninv, t.data());
+        }
+
+        void add(std::vector<uint32_t> &r, const std::vector<uint32_t> &a, const std::vector<uint32_t> &b) const
+        {
+            uint32_t carry = limb_ops::add_n(r.data(), a.data(), b.data(), k);
+            if (carry || limb_ops::cmp_n(r.data(), n.data(), k) >= 0)
+                limb_ops::sub_n(r.data(), r.data(), n.data(), k);
+        }
+
+        void sub(std::vector<uint32_t> &r, const std::vector<uint32_t> &a, const std::vector<uint32_t> &b) const
+        {
+            if (limb_ops::sub_n(r.data(), a.data(), b.data(), k))
+                limb_ops::add_n(r.data(), r.data(), n.data(), k);
+        }
+
+        // a / 2 mod n
+        void half(std::vector<uint32_t> &r, const std::vector<uint32_t> &a) const
+        {
+            uint32_t carry = 0;
+            if (a[0] & 1)
+                carry = limb_ops::add_n(r.data(), a.data(), n.data(), k);
+            else
+                r = a;
+            limb_ops::rshift(r.data(), r.data(), k, 1);
+            r[k - 1] |= carry << 31;
+        }
+    };
+
+    // |x| modulo each of the small trial-division primes
+    static std::vector<uint32_t> small_prime_residues(const BasicBigInt &x)
+    {
+        const limb_ops::SmallPrimes &sp = limb_ops::small_primes();
+        std::vector<uint32_t> groups(sp.products.size());
+        limb_ops::mod_1_multi(x.digits.data(), x.digits.size(), sp.products.data(), sp.products.size(), groups.data());
+        std::vector<uint32_t> residues(sp.primes.size());
+        for (size_t g = 0, i = 0; g < groups.size(); ++g)
+        {
+            for (; i < sp.group_end[g]; ++i)
+                residues[i] = groups[g] % sp.primes[i];
+        }
+        return residues;
+    }
+
+    // BPSW plus extra Miller-Rabin rounds on an odd n free of small factors
+    static bool bpsw(const BasicBigInt &n, int rounds)
+    {
+        Montgomery mf(n);
+        BasicBigInt d = n - BasicBigInt(1);
+        size_t s = d.countr_zero();
+        d >>= static_cast<int>(s);
+        if (!strong_probable_prime(mf, d, s, nullptr) || !strong_lucas_probable_prime(n, mf))
+            return false;
+        std::mt19937_64 rng(n.low_u64());
+        BasicBigInt span = n - BasicBigInt(3);
+        for (int i = 0; i < rounds; ++i)
+        {
+            BasicBigInt base;
+            base.digits.resize(n.digits.size());
+            for (uint32_t &w : base.digits)
+                w = static_cast<uint32_t>(rng());
+            base.trim();
+            base = base % span + BasicBigInt(2);
+            std::vector<uint32_t> b = mf.to_form(base);
+            if (!strong_probable_prime(mf, d, s, &b))
+                return false;
+        }
+        return true;
+    }
+
+    // Strong probable-prime test for n - 1 = d * 2^s to the given base in Montgomery
+    // form; a null base means 2, where each multiplication becomes a modular doubling
+    static bool strong_probable_prime(Montgomery &mf, const BasicBigInt &d, size_t s, const std::vector<uint32_t> *base)
+    {
+        std::vector<uint32_t> one = mf.to_form(BasicBigInt(1));
+        std::vector<uint32_t> minus_one(mf.k);
+        limb_ops::sub_n(minus_one.data(), mf.n.data(), one.data(), mf.k);
+        std::vector<uint32_t> x = one;
+        for (size_t i = d.bit_length(); i-- > 0;)
+        {
+            mf.mul(x, x, x);
+            if (d.test_bit(i))
+            {
+                if (base)
+                    mf.mul(x, x, *base);
+                else
+                    mf.add(x, x, x);
+            }
+        }
+        if (x == one || x == minus_one)
+            return true;
+        for (size_t r = 1; r < s; ++r)
+        {
+            mf.mul(x, x, x);
+            if (x == minus_one)
+                return true;
+            if (x == one)
+                return false;
+        }
+        return false;
+    }
+
+    // Jacobi symbol (D/n) for a small odd D, |D| >= 3, and odd n > 0
+    static int jacobi_small(int64_t D, const BasicBigInt &n)
+    {
+        uint32_t a = static_cast<uint32_t>(D < 0 ? -D : D);
+        int j = limb_ops::jacobi_u32(limb_ops::mod_1(n.digits.data(), n.digits.size(), a), a);
+        bool n3 = (n.digits[0] & 3) == 3;
+        // Reciprocity (a/n) = (n/a) unless both are 3 mod 4; (-1/n) = -1 iff n = 3 mod 4
+        if ((a & 3) == 3 && n3)
+            j = -j;
+        if (D < 0 && n3)
+            j = -j;
+        return j;
+    }
+
+    // Strong Lucas test with P = 1, Q = (1 - D)/4 and D the first of 5, -7, 9, -11, ...
+    // with (D/n) = -1. For n + 1 = d * 2^s, n passes if U_d = 0 or V_(d*2^r) = 0 for
+    // some r < s. U, V and Q^m are built by doubling along the bits of d.
+    static bool strong_lucas_probable_prime(const BasicBigInt &n, Montgomery &mf)
+    {
+        int64_t D = 5;
+        for (int tries = 0;; ++tries)
+        {
+            int j = jacobi_small(D, n);
+            if (j == -1)
+                break;
+            if (j == 0 && !(n == BasicBigInt(D < 0 ? -D : D)))
+                return false;
+            // A square n has no such D
+            if (tries == 8 && is_perfect_square(n))
+                return false;
+            D = D > 0 ? -(D + 2) : -D + 2;
+        }
+        std::vector<uint32_t> Dm = mf.to_form(mod_floor(BasicBigInt(D), n));
+        std::vector<uint32_t> Qm = mf.to_form(mod_floor(BasicBigInt((1 - D) / 4), n));
+        BasicBigInt d = n + BasicBigInt(1);
+        size_t s = d.countr_zero();
+        d >>= static_cast<int>(s);
+        std::vector<uint32_t> U = mf.to_form(BasicBigInt(1));
+        std::vector<uint32_t> V = U;
+        std::vector<uint32_t> Qk = Qm;
+        std::vector<uint32_t> tmp(mf.k);
+        for (size_t i = d.bit_length() - 1; i-- > 0;)
+        {
+            // (U, V)_2m = (U*V, V^2 - 2Q^m)
+            mf.mul(U, U, V);
+            mf.mul(V, V, V);
+            mf.sub(V, V, Qk);
+            mf.sub(V, V, Qk);
+            mf.mul(Qk, Qk, Qk);
+            if (d.test_bit(i))
+            {
+                // (U, V)_(m+1) = ((U + V)/2, (D*U + V)/2)
+                mf.mul(tmp, Dm, U);
+                mf.add(tmp, tmp, V);
+                mf.add(U, U, V);
+                mf.half(U, U);
+                mf.half(V, tmp);
+                mf.mul(Qk, Qk, Qm);
+            }
+        }
+        auto is_zero = [](const std::vector<uint32_t> &v) {
+            return std::all_of(v.begin(), v.end(), [](uint32_t w) { return w == 0; });
+        };
+        if (is_zero(U) || is_zero(V))
+            return true;
+        for (size_t r = 1; r < s; ++r)
+        {
+            mf.mul(V, V, V);
+            mf.sub(V, V, Qk);
+            mf.sub(V, V, Qk);
+            if (is_zero(V))
+                return true;
+            mf.mul(Qk, Qk, Qk);
+        }
+        return false;
+    }
+
+    // Product of v, splitting by count so that both halves, and so the operands
+    // of every multiplication, are of similar size. While spawn_depth > 0 the left
+    // half is computed on its own thread.
+    static BasicBigInt product_tree(std::span<const BasicBigInt> v, int spawn_depth = 0)
+    {
+        if (v.empty())
+            return BasicBigInt(1);
+        if (v.size() == 1)
+            return v[0];
+        if (v.size() == 2)
+            return v[0] * v[1];
+        size_t mid = v.size() / 2;
+        if (spawn_depth > 0)
+        {
+            auto left = std::async(std::launch::async, [=] { return product_tree(v.first(mid), spawn_depth - 1); });
+            BasicBigInt right = product_tree(v.subspan(mid), spawn_depth - 1);
+            return left.get() * right;
+        }
+        return product_tree(v.first(mid)) * product_tree(v.subspan(mid));
+    }
+
+    // Tree levels that get their own thread in parallel mode: enough to occupy every
+    // hardware thread, none on a single core
+    static int parallel_depth(bool parallel)
+    {
+        if (!parallel)
+            return 0;
+        int depth = 0;
+        for (unsigned threads = std::thread::hardware_concurrency(); threads > 1; threads = (threads + 1) / 2)
+            ++depth;
+        return depth;
+    }
+
+    // Remainder-tree nodes are laid out like a segment tree: node i holds
+    // the product of its range, with children 2i + 1 and 2i + 2 splitting at the middle
+    static void build_product_nodes(std::vector<BasicBigInt> &nodes, size_t node, std::span<const BasicBigInt> moduli,
+                                    int spawn_depth)
+    {
+        if (moduli.size() == 1)
+        {
+            nodes[node] = moduli[0];
+            return;
+        }
+        size_t mid = moduli.size() / 2;
+        if (spawn_depth > 0)
+        {
+            auto left = std::async(std::launch::async, [&, mid] {
+                build_product_nodes(nodes, 2 * node + 1, moduli.first(mid), spawn_depth - 1);
+            });
+            build_product_nodes(nodes, 2 * node + 2, moduli.subspan(mid), spawn_depth - 1);
+            left.get();
+        }
+        else
+        {
+            build_product_nodes(nodes, 2 * node + 1, moduli.first(mid), 0);
+            build_product_nodes(nodes, 2 * node + 2, moduli.subspan(mid), 0);
+        }
+        nodes[node] = nodes[2 * node + 1] * nodes[2 * node + 2];
+    }
+
+    static void descend_remainders(const std::vector<BasicBigInt> &nodes, size_t node, const BasicBigInt &x,
+                                   BasicBigInt *out, size_t count, int spawn_depth)
+    {
+        BasicBigInt r = x % nodes[node];
+        if (count == 1)
+        {
+            *out = std::move(r);
+            return;
+        }
+        size_t mid = count / 2;
+        if (spawn_depth > 0)
+        {
+            auto left = std::async(std::launch::async, [&, mid] {
+                descend_remainders(nodes, 2 * node + 1, r, out, mid, spawn_depth - 1);
+            });
+            descend_remainders(nodes, 2 * node + 2, r, out + mid, count - mid, spawn_depth - 1);
+            left.get();
+        }
+        else
+        {
+            descend_remainders(nodes, 2 * node + 1, r, out, mid, 0);
+            descend_remainders(nodes, 2 * node + 2, r, out + mid, count - mid, 0);
+        }
+    }
+
+    // Product of word-sized factors: neighbours are packed into 64-bit leaves, which
+    // then go through the balanced product tree
+    static BasicBigInt word_product(const std::vector<uint32_t> &factors, const Alloc &alloc = Alloc())
+    {
+        std::vector<BasicBigInt> leaves;
+        uint64_t acc = 1;
+        for (uint32_t f : factors)
+        {
+            if (acc > UINT64_MAX / f)
+            {
+                leaves.emplace_back(acc);
+                acc = 1;
+            }
+            acc *= f;
+        }
+        leaves.emplace_back(acc);
+        BasicBigInt result(alloc);
+        result = product_tree(leaves);
+        return result;
+    }
+
+    // Odd part of n!: oddfact(n) = oddfact(n/2)^2 * oddswing(n), where the odd prime
+    // p divides swing(n) with exponent sum_i floor(n / p^i) mod 2
+    static BasicBigInt odd_factorial(uint32_t n, const std::vector<uint32_t> &primes)
+    {
+        if (n < 3)
+            return BasicBigInt(1);
+        BasicBigInt half = odd_factorial(n / 2, primes);
+        std::vector<uint32_t> swing;
+        for (size_t i = 1; i < primes.size() && primes[i] <= n; ++i)
+        {
+            uint32_t p = primes[i];
+            uint32_t power = 1;
+            for (uint32_t q = n / p; q != 0; q /= p)
+            {
+                if (q & 1)
+                    power *= p;
+            }
+            if (power > 1)
+                swing.push_back(power);
+        }
+        return half * half * word_product(swing);
+    }
+
+    // Sets f = F(n) and f_prev = F(n-1) (F(-1) = 1) by fast doubling along the bits of
+    // n. Each step costs two squarings:
+    //   F(2k+1) = 4F(k)^2 - F(k-1)^2 + 2(-1)^k,  F(2k-1) = F(k)^2 + F(k-1)^2,
+    //   F(2k) = F(2k+1) - F(2k-1)
+    static void fibonacci_pair(uint64_t n, BasicBigInt &f, BasicBigInt &f_prev)
+    {
+        f = BasicBigInt(0);
+        f_prev = BasicBigInt(1);
+        if (n == 0)
+            return;
+        f = BasicBigInt(1);
+        f_prev = BasicBigInt(0);
+        const BasicBigInt two(2);
+        for (int i = 62 - __builtin_clzll(n); i >= 0; --i)
+        {
+            // (f, f_prev) = (F(k), F(k-1)) with k = n >> (i + 1)
+            bool k_odd = (n >> (i + 1)) & 1;
+            BasicBigInt a = f * f;
+            BasicBigInt b = f_prev * f_prev;
+            BasicBigInt next = a;
+            next <<= 2;
+            next = next - b;
+            next = k_odd ? next - two : next + two;
+            BasicBigInt lower = a + b;
+            if ((n >> i) & 1)
+            {
+                f_prev = next - lower;
+                f = std::move(next);
+            }
+            else
+            {
+                f = next - lower;
+                f_prev = std::move(lower);
+            }
+        }
+    }
+
+    // Low 64 bits of the magnitude
+    uint64_t low_u64() const
+    {
+        uint64_t v = digits.empty() ? 0 : digits[0];
+        if (digits.size() > 1)
+            v |= uint64_t(digits[1]) << 32;
+        return v;
+    }
+
+    // Bits per digit for the power-of-two bases
+    static unsigned pow2_base_bits(int base)
+    {
+        switch (base)
+        {
+        case 2:
+            return 1;
+        case 8:
+            return 3;
+        case 16:
+            return 4;
+        case 32:
+            return 5;
+        default:
+            throw std::invalid_argument("BigInt: unsupported base " + std::to_string(base));
+        }
+    }
+
+    // Validated decimal parse for from_string, nine digits per multiply-add pass
+    static BasicBigInt from_decimal(const std::string &s, const Alloc &alloc)
+    {
+        size_t i = !s.empty() && (s[0] == '-' || s[0] == '+') ? 1 : 0;
+        if (i == s.size())
+            throw std::invalid_argument("BigInt::from_string: no digits");
+        BasicBigInt result(alloc);
+        result.digits.reserve((s.size() - i) / 9 + 1);
+        size_t chunk_len = (s.size() - i) % 9 ? (s.size() - i) % 9 : 9;
+        while (i < s.size())
+        {
+            uint32_t chunk = 0, scale = 1;
+            for (size_t end = i + chunk_len; i < end; ++i)
+            {
+                unsigned d = limb_ops::char_digit(s[i]);
+                if (d >= 10)
+                    throw std::invalid_argument("BigInt::from_string: invalid digit");
+                chunk = chunk * 10 + d;
+                scale *= 10;
+            }
+            chunk_len = 9;
+            // result = result * scale + chunk, which fits one more limb
+            size_t n = result.digits.size();
+            result.digits.push_back(limb_ops::mul_1(result.digits.data(), result.digits.data(), n, scale));
+            uint64_t carry = chunk;
+            for (size_t j = 0; carry; ++j)
+            {
+                carry += result.digits[j];
+                result.digits[j] = static_cast<uint32_t>(carry);
+                carry >>= 32;
+            }
+        }
+        result.negative = s[0] == '-';
+        result.trim();
+        return result;
+    }
+
+    static int stream_base(std::ios_base::fmtflags flags)
+    {
+        std::ios_base::fmtflags field = flags & std::ios_base::basefield;
+        return field == std::ios_base::hex ? 16 : field == std::ios_base::oct ? 8 : 10;
+    }
+
+    // Sign of |a| - |b|
+    static int cmp_magnitude(BigIntView a, BigIntView b)
+    {
+        size_t n = a.limbs.size();
+        if (n != b.limbs.size())
+            return n < b.limbs.size() ? -1 : 1;
+        return limb_ops::cmp_n(a.limbs.data(), b.limbs.data(), n);
+    }
+
+    bool same_allocator(const BasicBigInt &other) const
+    {
+        return get_allocator() == other.get_allocator();
+    }
+
+    // *this += (other_negative ? -|other| : |other|) in place; other may view *this
+    void add_signed(BigIntView other, bool other_negative)
+    {
+        size_t n = digits.size();
+        size_t m = other.limbs.size();
+        if (m == 0)
+            return;
+        if (negative == other_negative || n == 0)
+        {
+            negative = other_negative;
+            uint32_t carry;
+            if (n >= m)
+            {
+                carry = limb_ops::add(digits.data(), digits.data(), n, other.limbs.data(), m);
+            }
+            else
+            {
+                digits.resize(m);
+                carry = limb_ops::add(digits.data(), other.limbs.data(), m, digits.data(), n);
+            }
+            if (carry)
+                digits.push_back(carry);
+            return;
+        }
+        if (cmp_magnitude(*this, other) >= 0)
+        {
+            limb_ops::sub(digits.data(), digits.data(), n, other.limbs.data(), m);
+        }
+        else
+        {
+            digits.resize(m);
+            limb_ops::sub(digits.data(), other.limbs.data(), m, digits.data(), n);
+            negative = other_negative;
+        }
+        trim();
+    }
+
+    // a + b, or a - b when subtract, in a buffer sized for the result up front
+    static BasicBigInt sum_of(BigIntView a, BigIntView b, bool subtract, const Alloc &alloc)
+    {
+        BasicBigInt result(alloc);
+        result.digits.reserve(std::max(a.limbs.size(), b.limbs.size()) + 1);
+        result.digits.assign(a.limbs.begin(), a.limbs.end());
+        result.negative = a.negative;
+        result.add_signed(b, b.negative != subtract);
+        return result;
+    }
+
+    // Operands over the same limbs are squared
+    static BasicBigInt product_of(BigIntView a, BigIntView b, const Alloc &alloc)
+    {
+        BasicBigInt result(alloc);
+        if (a.isZero() || b.isZero())
+            return result;
+        size_t an = a.limbs.size();
+        size_t bn = b.limbs.size();
+        result.digits.resize(an + bn);
+        result.negative = a.negative != b.negative;
+        if (a.limbs.data() == b.limbs.data() && an == bn)
+            limb_ops::sqr(result.digits.data(), a.limbs.data(), an);
+        else
+            limb_ops::mul(result.digits.data(), a.limbs.data(), an, b.limbs.data(), bn);
+        result.trim();
+        return result;
+    }
+
+    // *this *= other; other may view *this
+    void multiply_by(BigIntView other)
+    {
+        if (isZero() || other.isZero())
+        {
+            digits.clear();
+            negative = false;
+            return;
+        }
+        bool product_negative = negative != other.negative;
+        size_t n = digits.size();
+        size_t m = other.limbs.size();
+        if (m == 1)
+        {
+            uint32_t carry = limb_ops::mul_1(digits.data(), digits.data(), n, other.limbs[0]);
+            if (carry)
+                digits.push_back(carry);
+        }
+        else
+        {
+            limb_ops::ScratchFrame frame;
+            uint32_t *p = frame.alloc(n + m);
+            if (other.limbs.data() == digits.data())
+                limb_ops::sqr(p, digits.data(), n);
+            else
+                limb_ops::mul(p, digits.data(), n, other.limbs.data(), m);
+            digits.assign(p, p + n + m);
+        }
+        negative = product_negative;
+        trim();
+    }
+
+    // *this += a * b, or -= when negate. The product is accumulated row by row into the
+    // destination limbs when the signs agree or when the destination is long enough that
+    // its sign cannot flip; otherwise it is formed in scratch and added as a whole.
+    void add_product(const BasicBigInt &a, const BasicBigInt &b, bool negate)
+    {
+        if (a.isZero() || b.isZero())
+            return;
+        if (&a == this || &b == this)
+        {
+            BasicBigInt p = a * b;
+            add_signed(p, p.negative != negate);
+            return;
+        }
+        const BasicBigInt &u = a.digits.size() >= b.digits.size() ? a : b;
+        const BasicBigInt &v = a.digits.size() >= b.digits.size() ? b : a;
+        size_t un = u.digits.size();
+        size_t vn = v.digits.size();
+        size_t pn = un + vn;
+        size_t n = digits.size();
+        bool product_negative = (a.negative != b.negative) != negate;
+        bool direct = limb_ops::addmul_direct(un, vn);
+        if (n == 0)
+            negative = product_negative;
+        if (negative == product_negative)
+        {
+            size_t m = std::max(n, pn) + 1;
+            digits.resize(m);
+            uint32_t *d = digits.data();
+            if (direct)
+            {
+                for (size_t j = 0; j < vn; ++j)
+                {
+                    uint32_t carry = limb_ops::addmul_1(d + j, u.digits.data(), un, v.digits[j]);
+                    limb_ops::add_1(d + j + un, d + j + un, m - j - un, carry);
+                }
+            }
+            else
+            {
+                limb_ops::ScratchFrame frame;
+                uint32_t *p = frame.alloc(pn);
+                limb_ops::mul(p, u.digits.data(), un, v.digits.data(), vn);
+                limb_ops::add(d, d, m, p, pn);
+            }
+            trim();
+            return;
+        }
+        // |*this| >= 2^(32(n-1)) >= 2^(32 pn) > |a * b|
+        if (direct && n > pn)
+        {
+            uint32_t *d = digits.data();
+            for (size_t j = 0; j < vn; ++j)
+            {
+                uint32_t borrow = limb_ops::submul_1(d + j, u.digits.data(), un, v.digits[j]);
+                limb_ops::sub_1(d + j + un, d + j + un, n - j - un, borrow);
+            }
+            trim();
+            return;
+        }
+        limb_ops::ScratchFrame frame;
+        uint32_t *p = frame.alloc(pn);
+        limb_ops::mul(p, u.digits.data(), un, v.digits.data(), vn);
+        while (p[pn - 1] == 0)
+            --pn;
+        int c = n != pn ? (n < pn ? -1 : 1) : limb_ops::cmp_n(digits.data(), p, n);
+        if (c >= 0)
+        {
+            limb_ops::sub(digits.data(), digits.data(), n, p, pn);
+        }
+        else
+        {
+            digits.resize(pn);
+            limb_ops::sub(digits.data(), p, pn, digits.data(), n);
+            negative = product_negative;
+        }
+        trim();
+    }
+
+    template <typename E>
+    void evaluate(const E &e, bool accumulate, bool negate)
+    {
+        std::array<expr::Term<Alloc>, E::terms> terms;
+        e.collect(terms.data(), negate);
+        evaluate_terms(terms.data(), E::terms, accumulate);
+    }
+
+    // *this = (accumulate ? *this : 0) + the signed sum of the terms. `acc = acc + ...`
+    // keeps acc's limbs in place; any other reference to *this evaluates into a fresh
+    // number first, since the terms must see the old value.
+    void evaluate_terms(const expr::Term<Alloc> *t, size_t count, bool accumulate)
+    {
+        size_t self_refs = 0;
+        const expr::Term<Alloc> *self = nullptr;
+        size_t bound = accumulate ? digits.size() : 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            self_refs += (t[i].x == this) + (t[i].y == this);
+            if (t[i].x == this && !t[i].y)
+                self = &t[i];
+            bound = std::max(bound, t[i].x->digits.size() + (t[i].y ? t[i].y->digits.size() : 0));
+        }
+        if (self_refs != 0 && (accumulate || self_refs != 1 || !self))
+        {
+            BasicBigInt result(get_allocator());
+            if (accumulate)
+                result = BasicBigInt(*this, get_allocator());
+            result.evaluate_terms(t, count, true);
+            *this = std::move(result);
+            return;
+        }
+        if (self)
+        {
+            if (self->negative && !isZero())
+                negative = !negative;
+        }
+        else if (!accumulate)
+        {
+            digits.clear();
+            negative = false;
+        }
+        // One limb for carries out of the sum, one for add_product's headroom
+        digits.reserve(bound + 2);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (&t[i] == self)
+                continue;
+            if (t[i].y)
+                add_product(*t[i].x, *t[i].y, t[i].negative);
+            else
+                add_signed(*t[i].x, t[i].x->negative != t[i].negative);
+        }
+    }
+
+    // Replaces *this with the compact value at p and returns its length
+    size_t read_compact(const std::byte *p, const std::byte *end)
+    {
+        uint64_t head;
+        size_t n = serial::get_varint(p, end, head);
+        if (n == 0)
+            throw std::invalid_argument("BigInt::decode_compact: truncated or overlong varint");
+        digits.clear();
+        if (!(head & 1))
+        {
+            uint64_t z = head >> 1;
+            uint64_t m = (z >> 1) + (z & 1);
+            negative = (z & 1) != 0;
+            if (m)
+                digits.push_back(static_cast<uint32_t>(m));
+            if (m >> 32)
+                digits.push_back(static_cast<uint32_t>(m >> 32));
+            return n;
+        }
+        uint64_t limbs = head >> 2;
+        if (limbs > static_cast<uint64_t>(end - p - n) / 4)
+            throw std::invalid_argument("BigInt::decode_compact: truncated input");
+        negative = (head & 2) != 0;
+        digits.resize(limbs);
+        for (uint32_t &d : digits)
+        {
+            d = uint32_t(p[n]) | uint32_t(p[n + 1]) << 8 | uint32_t(p[n + 2]) << 16 | uint32_t(p[n + 3]) << 24;
+            n += 4;
+        }
+        trim();
+        return n;
+    }
+
+    // Byte order, sign and normal form for freshly read limbs
+    void finish_load(const serial::Header &h, bool swap)
+    {
+        if (swap)
+            for (uint32_t &d : digits)
+                d = __builtin_bswap32(d);
+        negative = (h.flags & serial::FLAG_NEGATIVE) != 0;
+        trim();
+    }
+
+    // |x| += 2^n, used by set_bit/clear_bit when the two's-complement bit flips
+    void add_pow2_magnitude(size_t n)
+    {
+        size_t w = n / 32;
+        if (digits.size() <= w)
+            digits.resize(w + 1);
+        uint64_t carry = uint64_t(1) << (n % 32);
+        for (size_t i = w; carry; ++i)
+        {
+            if (i == digits.size())
+                digits.push_back(0);
+            uint64_t sum = uint64_t(digits[i]) + carry;
+            digits[i] = static_cast<uint32_t>(sum);
+            carry = sum >> 32;
+        }
+    }
+
+    // |x| -= 2^n, requires |x| >= 2^n
+    void sub_pow2_magnitude(size_t n)
+    {
+        size_t w = n / 32;
+        uint64_t borrow = uint64_t(1) << (n % 32);
+        for (size_t i = w; borrow; ++i)
+        {
+            uint64_t cur = digits[i];
+            digits[i] = static_cast<uint32_t>(cur - borrow);
+            borrow = cur < borrow ? 1 : 0;
+        }
+        trim();
+    }
+
+    // Bitwise op into r, whose storage a or b may view. Non-negative operands take the
+    // vector kernels; any negative operand goes through the single-pass two's-complement kernel.
+    template <limb_ops::BitOp Op>
+    static void bitwise(BasicBigInt &r, BigIntView a, BigIntView b)
+    {
+        size_t an = a.limbs.size();
+        size_t bn = b.limbs.size();
+        bool aneg = a.negative;
+        bool bneg = b.negative;
+        if constexpr (Op == limb_ops::BIT_NOT)
+        {
+            bn = 0;
+            bneg = false;
+        }
+        // An operand over r's limbs is re-pointed after r is resized
+        const uint32_t *ap = a.limbs.data();
+        const uint32_t *bp = b.limbs.data();
+        bool a_in_r = an != 0 && ap == r.digits.data();
+        bool b_in_r = bn != 0 && bp == r.digits.data();
+        auto resize = [&](size_t n) {
+            r.digits.resize(n);
+            if (a_in_r)
+                ap = r.digits.data();
+            if (b_in_r)
+                bp = r.digits.data();
+        };
+        if (!aneg && !bneg && Op != limb_ops::BIT_NOT)
+        {
+            size_t lo = std::min(an, bn);
+            size_t n = Op == limb_ops::BIT_AND ? lo : std::max(an, bn);
+            resize(n);
+            limb_ops::bitop_n<Op>(r.digits.data(), ap, bp, lo);
+            const uint32_t *longer = an >= bn ? ap : bp;
+            if (n > lo && longer != r.digits.data())
+                std::copy(longer + lo, longer + n, r.digits.begin() + lo);
+            r.negative = false;
+            r.trim();
+            return;
+        }
+        size_t n = std::max(an, bn) + 1;
+        // A non-negative AND operand bounds the result to its own length
+        if (Op == limb_ops::BIT_AND && (!aneg || !bneg))
+            n = !aneg ? an : bn;
+        resize(n);
+        r.negative = limb_ops::bitop_signed<Op>(r.digits.data(), n, ap, an, aneg, bp, bn, bneg);
+        r.trim();
+    }
+
+    // Division by small integer
+    uint32_t divmod_small(uint32_t divisor)
+    {
+        uint64_t remainder = 0;
+        for (int i = static_cast<int>(digits.size()) - 1; i >= 0; --i)
+        {
+            uint64_t current = (remainder << 32) + digits[i];
+            digits[i] = static_cast<uint32_t>(current / divisor);
+            remainder = current % divisor;
+        }
+        trim();
+        return static_cast<uint32_t>(remainder);
+    }
+
+    // Division and Modulo
+    static void divmod(BigIntView a, BigIntView b, BasicBigInt &quotient, BasicBigInt &remainder)
+    {
+        if (b.isZero())
+        {
+            throw std::runtime_error("Division by zero");
+        }
+        if (a.isZero())
+        {
+            quotient = BasicBigInt(0);
+            remainder = BasicBigInt(0);
+            return;
+        }
+        size_t an = a.limbs.size();
+        size_t bn = b.limbs.size();
+        if (an < bn || (an == bn && limb_ops::cmp_n(a.limbs.data(), b.limbs.data(), an) < 0))
+        {
+            if (a.limbs.data() != remainder.digits.data())
+                remainder.digits.assign(a.limbs.begin(), a.limbs.end());
+            remainder.negative = a.negative;
+            quotient.digits.clear();
+            quotient.negative = false;
+            return;
+        }
+        // Both results are built in scratch first, so they may alias a or b
+        limb_ops::ScratchFrame frame;
+        uint32_t *q = frame.alloc(an - bn + 1);
+        uint32_t *r = frame.alloc(bn);
+        limb_ops::divrem(q, r, a.limbs.data(), an, b.limbs.data(), bn);
+        bool quotient_negative = a.negative != b.negative;
+        bool remainder_negative = a.negative;
+        quotient.digits.assign(q, q + an - bn + 1);
+        quotient.negative = quotient_negative;
+        quotient.trim();
+        remainder.digits.assign(r, r + bn);
+        remainder.negative = remainder_negative;
+        remainder.trim();
+    }
+};
+
+using BigInt = BasicBigInt<>;
+
+inline std::string BigIntView::to_string(int base, bool upper) const
+{
+    return BigInt(*this).to_string(base, upper);
+}
+
+inline std::ostream &operator<<(std::ostream &os, BigIntView v)
+{
+    return os << BigInt(v);
+}
+
+// Operators with a view (or a number read as one) on the left
+inline BigInt operator+(BigIntView a, BigIntView b)
+{
+    return BigInt::sum_of(a, b, false, {});
+}
+
+inline BigInt operator-(BigIntView a, BigIntView b)
+{
+    return BigInt::sum_of(a, b, true, {});
+}
+
+inline BigInt operator*(BigIntView a, BigIntView b)
+{
+    return BigInt::product_of(a, b, {});
+}
+
+inline BigInt operator/(BigIntView a, BigIntView b)
+{
+    BigInt quotient, remainder;
+    BigInt::divmod(a, b, quotient, remainder);
+    return quotient;
+}
+
+inline BigInt operator%(BigIntView a, BigIntView b)
+{
+    BigInt quotient, remainder;
+    BigInt::divmod(a, b, quotient, remainder);
+    return remainder;
+}
+
+inline BigInt operator&(BigIntView a, BigIntView b)
+{
+    BigInt result;
+    BigInt::bitwise<limb_ops::BIT_AND>(result, a, b);
+    return result;
+}
+
+inline BigInt operator|(BigIntView a, BigIntView b)
+{
+    BigInt result;
+    BigInt::bitwise<limb_ops::BIT_OR>(result, a, b);
+    return result;
+}
+
+inline BigInt operator^(BigIntView a, BigIntView b)
+{
+    BigInt result;
+    BigInt::bitwise<limb_ops::BIT_XOR>(result, a, b);
+    return result;
+}
+
+inline BigInt operator-(BigIntView a)
+{
+    BigInt result(a);
+    if (!result.isZero())
+        result.negative = !result.negative;
+    return result;
+}
+
+inline bool operator<(BigIntView a, BigIntView b)
+{
+    return BigInt::compare(a, b) < 0;
+}
+
+inline bool operator>=(BigIntView a, BigIntView b)
+{
+    return BigInt::compare(a, b) >= 0;
+}
+
+inline bool operator==(BigIntView a, BigIntView b)
+{
+    return a.negative == b.negative && std::ranges::equal(a.limbs, b.limbs);
+}
+
+// Entry point for lazy evaluation: lazy(a) * b + lazy(c) * d - e
+template <typename Alloc>
+expr::Value<Alloc> lazy(const BasicBigInt<Alloc> &x)
+{
+    return {x};
+}
+
+// Immutable, reference-counted handle on a BasicBigInt for values that are read far more
+// often than written. Copies share one number through an atomic count, so handing a
+// large constant to many tasks copies a pointer. The mutating operators copy the number
+// first unless this handle is its only owner (copy-on-write). A default handle is zero.
+template <typename Alloc>
+class BasicSharedBigInt
+{
+public:
+    using value_type = BasicBigInt<Alloc>;
+    using allocator_type = Alloc;
+
+    BasicSharedBigInt() = default;
+
+    BasicSharedBigInt(value_type value) : ptr(std::make_shared<value_type>(std::move(value))) {}
+
+    const value_type &get() const
+    {
+        return ptr ? *ptr : zero();
+    }
+
+    operator const value_type &() const
+    {
+        return get();
+    }
+
+    const value_type &operator*() const
+    {
+        return get();
+    }
+
+    const value_type *operator->() const
+    {
+        return &get();
+    }
+
+    // Number of handles sharing the value, 0 for a default handle
+    long use_count() const
+    {
+        return ptr.use_count();
+    }
+
+    // Writable access, copying the value first when another handle shares it. No other
+    // handle can appear while this one is the sole owner. use_count() is only a relaxed
+    // load, though, so once it reads 1 the acquire fence pairs with the release decrement
+    // of the last other owner: its reads of the value happen before our writes.
+    value_type &mutate()
+    {
+        if (!ptr)
+            ptr = std::make_shared<value_type>();
+        else if (ptr.use_count() != 1)
+            ptr = std::make_shared<value_type>(*ptr, ptr->get_allocator());
+        else
+            std::atomic_thread_fence(std::memory_order_acquire);
+        return *ptr;
+    }
+
+    BasicSharedBigInt &operator+=(const value_type &other)
+    {
+        mutate() += other;
+        return *this;
+    }
+
+    BasicSharedBigInt &operator-=(const value_type &other)
+    {
+        mutate() -= other;
+        return *this;
+    }
+
+    BasicSharedBigInt &operator*=(const value_type &other)
+    {
+        mutate() *= other;
+        return *this;
+    }
+
+    BasicSharedBigInt &operator&=(const value_type &other)
+    {
+        mutate() &= other;
+        return *this;
+    }
+
+    BasicSharedBigInt &operator|=(const value_type &other)
+    {
+        mutate() |= other;
+        return *this;
+    }
+
+    BasicSharedBigInt &operator^=(const value_type &other)
+    {
+        mutate() ^= other;
+        return *this;
+    }
+
+    BasicSharedBigInt &operator<<=(int shift)
+    {
+        mutate() <<= shift;
+        return *this;
+    }
+
+    BasicSharedBigInt &operator>>=(int shift)
+    {
+        mutate() >>= shift;
+        return *this;
+    }
+
+    friend std::ostream &operator<<(std::ostream &os, const BasicSharedBigInt &x)
+    {
+        return os << x.get();
+    }
+
+private:
+    static const value_type &zero()
+    {
+        static const value_type z;
+        return z;
+    }
+
+    std::shared_ptr<value_type> ptr;
+};
+
+using SharedBigInt = BasicSharedBigInt<>;
+
+namespace pmr
+{
+    using BigInt = BasicBigInt<std::pmr::polymorphic_allocator<uint32_t>>;
+    using SharedBigInt = BasicSharedBigInt<std::pmr::polymorphic_allocator<uint32_t>>;
+}
+
+// Operators on a SharedBigInt and a BigInt or another SharedBigInt of the same allocator
+// read through the handle and return a plain number; an rvalue BigInt operand keeps its
+// buffer-reusing overload.
+template <typename T>
+struct is_shared_bigint : std::false_type
+{
+};
+
+template <typename Alloc>
+struct is_shared_bigint<BasicSharedBigInt<Alloc>> : std::true_type
+{
+};
+
+template <typename T>
+concept BigIntOrShared = is_shared_bigint<T>::value || std::same_as<T, BasicBigInt<typename T::allocator_type>>;
+
+template <typename L, typename R>
+concept SharedOperands = BigIntOrShared<std::remove_cvref_t<L>> && BigIntOrShared<std::remove_cvref_t<R>> &&
+                         (is_shared_bigint<std::remove_cvref_t<L>>::value || is_shared_bigint<std::remove_cvref_t<R>>::value) &&
+                         std::same_as<typename std::remove_cvref_t<L>::allocator_type, typename std::remove_cvref_t<R>::allocator_type>;
+
+template <typename Alloc>
+const BasicBigInt<Alloc> &unshared(const BasicSharedBigInt<Alloc> &x)
+{
+    return x.get();
+}
+
+template <typename Alloc>
+const BasicBigInt<Alloc> &unshared(const BasicBigInt<Alloc> &x)
+{
+    return x;
+}
+
+template <typename Alloc>
+BasicBigInt<Alloc> &&unshared(BasicBigInt<Alloc> &&x)
+{
+    return std::move(x);
+}
+
+template <typename L, typename R>
+    requires SharedOperands<L, R>
+auto operator+(L &&a, R &&b)
+{
+    return unshared(std::forward<L>(a)) + unshared(std::forward<R>(b));
+}
+
+template <typename L, typename R>
+    requires SharedOperands<L, R>
+auto operator-(L &&a, R &&b)
+{
+    return unshared(std::forward<L>(a)) - unshared(std::forward<R>(b));
+}
+
+template <typename L, typename R>
+    requires SharedOperands<L, R>
+auto operator*(L &&a, R &&b)
+{
+    return unshared(std::forward<L>(a)) * unshared(std::forward<R>(b));
+}
+
+template <typename L, typename R>
+    requires SharedOperands<L, R>
+auto operator/(L &&a, R &&b)
+{
+    return unshared(std::forward<L>(a)) / unshared(std::forward<R>(b));
+}
+
+template <typename L, typename R>
+    requires SharedOperands<L, R>
+auto operator%(L &&a, R &&b)
+{
+    return unshared(std::forward<L>(a)) % unshared(std::forward<R>(b));
+}
+
+template <typename L, typename R>
+    requires SharedOperands<L, R>
+auto operator&(L &&a, R &&b)
+{
+    return unshared(std::forward<L>(a)) & unshared(std::forward<R>(b));
+}
+
+template <typename L, typename R>
+    requires SharedOperands<L, R>
+auto operator|(L &&a, R &&b)
+{
+    return unshared(std::forward<L>(a)) | unshared(std::forward<R>(b));
+}
+
+template <typename L, typename R>
+    requires SharedOperands<L, R>
+auto operator^(L &&a, R &&b)
+{
+    return unshared(std::forward<L>(a)) ^ unshared(std::forward<R>(b));
+}
+
+template <typename L, typename R>
+    requires SharedOperands<L, R>
+bool operator<(const L &a, const R &b)
+{
+    return unshared(a) < unshared(b);
+}
+
+template <typename L, typename R>
+    requires SharedOperands<L, R>
+bool operator>=(const L &a, const R &b)
+{
+    return unshared(a) >= unshared(b);
+}
+
+template <typename L, typename R>
+    requires SharedOperands<L, R>
+bool operator==(const L &a, const R &b)
+{
+    return unshared(a) == unshared(b);
+}
+
+template <typename Alloc>
+BasicBigInt<Alloc> operator-(const BasicSharedBigInt<Alloc> &x)
+{
+    return -x.get();
+}
+
+template <typename Alloc>
+BasicBigInt<Alloc> operator~(const BasicSharedBigInt<Alloc> &x)
+{
+    return ~x.get();
+}
+
+template <typename Alloc>
+BasicBigInt<Alloc> operator<<(const BasicSharedBigInt<Alloc> &x, int shift)
+{
+    return x.get() << shift;
+}
+
+template <typename Alloc>
+BasicBigInt<Alloc> operator>>(const BasicSharedBigInt<Alloc> &x, int shift)
+{
+    return x.get() >> shift;
+}
+
+// Other operands of a lazy expression bind to plain numbers, so pass handles as *h
+template <typename Alloc>
+expr::Value<Alloc> lazy(const BasicSharedBigInt<Alloc> &x)
+{
+    return {x.get()};
+}
+
+// A number, a view of it and a handle on it hash alike. std::hash<BigIntView> is
+// transparent, so views can look up numbers in a container declared with it and a
+// transparent equality, e.g. std::unordered_set<BigInt, std::hash<BigIntView>,
+// std::equal_to<>>; the default std::hash<BigInt> and std::equal_to<BigInt> are not.
+template <>
+struct std::hash<BigIntView>
+{
+    using is_transparent = void;
+
+    size_t operator()(BigIntView v) const
+    {
+        return v.hash();
+    }
+};
+
+template <typename Alloc>
+struct std::hash<BasicBigInt<Alloc>>
+{
+    size_t operator()(const BasicBigInt<Alloc> &x) const
+    {
+        return BigIntView(x).hash();
+    }
+};
+
+template <typename Alloc>
+struct std::hash<BasicSharedBigInt<Alloc>>
+{
+    size_t operator()(const BasicSharedBigInt<Alloc> &x) const
+    {
+        return BigIntView(x).hash();
+    }
+};
+
+#ifdef BIGINT_MMAP
+// Many numbers in one file: a 64-byte header, the limbs of every number back to back in
+// one heap, then an index of count + 1 limb offsets into the heap (bit 63 of entry i is
+// the sign of number i; the last entry is the heap end). Byte order is native, tagged as
+// in namespace serial.
+//
+// In read mode the file is mapped and operator[] returns views straight into the mapping,
+// so a table far larger than RAM costs only the pages it touches. Write mode (new file)
+// and append mode (extend an existing one) stream limbs to the end of the heap and keep
+// the index in memory; close() writes the index and header, and the file cannot be read
+// until then.
+class MappedBigIntArray
+{
+public:
+    enum class Mode
+    {
+        read,
+        write,
+        append
+    };
+
+    enum class Access
+    {
+        random,
+        sequential
+    };
+
+    explicit MappedBigIntArray(const std::string &path, Mode mode = Mode::read) : mode(mode)
+    {
+        if (mode == Mode::read)
+            map(path);
+        else
+            open_writer(path);
+    }
+
+    MappedBigIntArray(MappedBigIntArray &&other) noexcept
+        : mode(other.mode), base(std::exchange(other.base, nullptr)), length(std::exchange(other.length, 0)),
+          index(other.index), heap(other.heap), count(std::exchange(other.count, 0)), out(std::move(other.out)),
+          offsets(std::move(other.offsets)), heap_limbs(other.heap_limbs)
+    {
+    }
+
+    MappedBigIntArray &operator=(MappedBigIntArray &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            mode = other.mode;
+            base = std::exchange(other.base, nullptr);
+            length = std::exchange(other.length, 0);
+            index = other.index;
+            heap = other.heap;
+            count = std::exchange(other.count, 0);
+            out = std::move(other.out);
+            offsets = std::move(other.offsets);
+            heap_limbs = other.heap_limbs;
+        }
+        return *this;
+    }
+
+    MappedBigIntArray(const MappedBigIntArray &) = delete;
+    MappedBigIntArray &operator=(const MappedBigIntArray &) = delete;
+
+    // A writer is closed here, but errors are only reported by an explicit close()
+    ~MappedBigIntArray()
+    {
+        release();
+    }
+
+    size_t size() const
+    {
+        return mode == Mode::read ? count : offsets.size();
+    }
+
+    // Number i of a file opened for reading, without bounds checks
+    BigIntView operator[](size_t i) const
+    {
+        uint64_t start = index[i] & ~SIGN;
+        uint64_t end = index[i + 1] & ~SIGN;
+        return BigIntView(std::span<const uint32_t>(heap + start, end - start), (index[i] & SIGN) != 0);
+    }
+
+    // As operator[], but checks i and the index entries against the file
+    BigIntView at(size_t i) const
+    {
+        if (mode != Mode::read || i >= count)
+            throw std::out_of_range("MappedBigIntArray::at: index out of range");
+        uint64_t start = index[i] & ~SIGN;
+        uint64_t end = index[i + 1] & ~SIGN;
+        if (start > end || end > heap_end())
+            throw std::invalid_argument("MappedBigIntArray::at: corrupt index");
+        return (*this)[i];
+    }
+
+    // Read-ahead policy for the whole mapping
+    void advise(Access access) const
+    {
+        if (base)
+            ::madvise(base, length, access == Access::random ? MADV_RANDOM : MADV_SEQUENTIAL);
+    }
+
+    // Asks the kernel to start reading the limbs of numbers [first, first + n)
+    void prefetch(size_t first, size_t n) const
+    {
+        if (!base || n == 0 || first >= count)
+            return;
+        n = std::min(n, count - first);
+        const char *from = reinterpret_cast<const char *>(heap + (index[first] & ~SIGN));
+        const char *to = reinterpret_cast<const char *>(heap + (index[first + n] & ~SIGN));
+        char *start = static_cast<char *>(base) + (from - static_cast<const char *>(base)) / page_size() * page_size();
+        ::madvise(start, static_cast<size_t>(to - start), MADV_WILLNEED);
+    }
+
+    // Appends a number to a file opened for writing or appending
+    void push_back(BigIntView v)
+    {
+        if (mode == Mode::read)
+            throw std::logic_error("MappedBigIntArray::push_back: opened for reading");
+        offsets.push_back(heap_limbs | (v.negative ? SIGN : 0));
+        out.write(reinterpret_cast<const char *>(v.limbs.data()), static_cast<std::streamsize>(v.limbs.size() * sizeof(uint32_t)));
+        heap_limbs += v.limbs.size();
+        if (!out)
+            throw std::runtime_error("MappedBigIntArray::push_back: write failed");
+    }
+
+    // Writes the index and header of a file opened for writing or appending
+    void close()
+    {
+        if (!out.is_open())
+            return;
+        static constexpr char zeros[HEAP_OFFSET] = {};
+        uint64_t heap_bytes = HEAP_OFFSET + heap_limbs * sizeof(uint32_t);
+        uint64_t index_offset = (heap_bytes + 7) / 8 * 8;
+        out.write(zeros, static_cast<std::streamsize>(index_offset - heap_bytes));
+        out.write(reinterpret_cast<const char *>(offsets.data()), static_cast<std::streamsize>(offsets.size() * sizeof(uint64_t)));
+        out.write(reinterpret_cast<const char *>(&heap_limbs), sizeof(heap_limbs));
+        Header h = {{'B', 'I', 'G', 'A'}, serial::VERSION, serial::NATIVE, {}, offsets.size(), index_offset};
+        out.seekp(0);
+        out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+        out.write(zeros, HEAP_OFFSET - sizeof(h));
+        out.close();
+        if (out.fail())
+            throw std::runtime_error("MappedBigIntArray::close: write failed");
+    }
+
+private:
+    struct Header
+    {
+        char magic[4]; // "BIGA"
+        uint8_t version;
+        uint8_t endian;
+        uint8_t reserved[2];
+        uint64_t count;
+        uint64_t index_offset; // in bytes from the start of the file
+    };
+
+    static constexpr size_t HEAP_OFFSET = 64;
+    static constexpr uint64_t SIGN = uint64_t(1) << 63;
+
+    void release() noexcept
+    {
+        if (base)
+            ::munmap(base, length);
+        base = nullptr;
+        try
+        {
+            close();
+        }
+        catch (const std::exception &)
+        {
+        }
+    }
+
+    // madvise wants page-aligned addresses; pages are 16K or 64K on some arm64 and ppc64le
+    static size_t page_size()
+    {
+        static const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        return page;
+    }
+
+    size_t heap_end() const
+    {
+        return (reinterpret_cast<const char *>(index) - reinterpret_cast<const char *>(heap)) / sizeof(uint32_t);
+    }
+
+    // Validates h against a file of `size` bytes
+    static void check_header(const Header &h, size_t size, const std::string &path)
+    {
+        if (std::memcmp(h.magic, "BIGA", 4) != 0 || h.version != serial::VERSION)
+            throw std::invalid_argument("MappedBigIntArray: " + path + " is not a BigInt array");
+        if (h.endian != serial::NATIVE)
+            throw std::invalid_argument("MappedBigIntArray: " + path + " is not in native byte order");
+        if (h.index_offset < HEAP_OFFSET || h.index_offset % 8 != 0 || h.count >= size / sizeof(uint64_t) ||
+            h.index_offset > size - (h.count + 1) * sizeof(uint64_t))
+            throw std::invalid_argument("MappedBigIntArray: " + path + " is truncated");
+    }
+
+    void map(const std::string &path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), "MappedBigIntArray: open " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < HEAP_OFFSET + sizeof(uint64_t))
+        {
+            ::close(fd);
+            throw std::invalid_argument("MappedBigIntArray: " + path + " is truncated");
+        }
+        length = static_cast<size_t>(st.st_size);
+        void *p = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED)
+            throw std::system_error(errno, std::generic_category(), "MappedBigIntArray: mmap " + path);
+        base = p;
+        Header h;
+        std::memcpy(&h, base, sizeof(h));
+        try
+        {
+            check_header(h, length, path);
+        }
+        catch (...)
+        {
+            ::munmap(base, length);
+            base = nullptr;
+            throw;
+        }
+        count = h.count;
+        heap = reinterpret_cast<const uint32_t *>(static_cast<const char *>(base) + HEAP_OFFSET);
+        index = reinterpret_cast<const uint64_t *>(static_cast<const char *>(base) + h.index_offset);
+        advise(Access::random);
+        size_t index_page = h.index_offset / page_size() * page_size();
+        ::madvise(static_cast<char *>(base) + index_page, length - index_page, MADV_WILLNEED);
+    }
+
+    void open_writer(const std::string &path)
+    {
+        if (mode == Mode::append)
+        {
+            std::ifstream in(path, std::ios::binary);
+            if (in)
+            {
+                // The old index is overwritten by new limbs and rewritten by close()
+                Header h;
+                in.read(reinterpret_cast<char *>(&h), sizeof(h));
+                in.seekg(0, std::ios::end);
+                check_header(h, in ? static_cast<size_t>(in.tellg()) : 0, path);
+                offsets.resize(h.count);
+                in.seekg(static_cast<std::streamoff>(h.index_offset));
+                in.read(reinterpret_cast<char *>(offsets.data()), static_cast<std::streamsize>(h.count * sizeof(uint64_t)));
+                in.read(reinterpret_cast<char *>(&heap_limbs), sizeof(heap_limbs));
+                if (!in)
+                    throw std::invalid_argument("MappedBigIntArray: " + path + " is truncated");
+                // New limbs go right after the heap and must not start inside the index
+                if (heap_limbs > (h.index_offset - HEAP_OFFSET) / sizeof(uint32_t))
+                    throw std::invalid_argument("MappedBigIntArray: " + path + " has a corrupt heap size");
+                in.close();
+                out.open(path, std::ios::binary | std::ios::in | std::ios::out);
+                out.seekp(static_cast<std::streamoff>(HEAP_OFFSET + heap_limbs * sizeof(uint32_t)));
+                if (!out)
+                    throw std::system_error(errno, std::generic_category(), "MappedBigIntArray: open " + path);
+                return;
+            }
+        }
+        out.open(path, std::ios::binary | std::ios::out | std::ios::trunc);
+        if (!out)
+            throw std::system_error(errno, std::generic_category(), "MappedBigIntArray: open " + path);
+        static constexpr char zeros[HEAP_OFFSET] = {};
+        out.write(zeros, HEAP_OFFSET);
+    }
+
+    Mode mode;
+    // Read mode
+    void *base = nullptr;
+    size_t length = 0;
+    const uint64_t *index = nullptr;
+    const uint32_t *heap = nullptr;
+    size_t count = 0;
+    // Write and append modes
+    std::fstream out;
+    std::vector<uint64_t> offsets;
+    uint64_t heap_limbs = 0;
+};
+#endif
+
+// Moduli of a residue number system: distinct primes just below 2^31, together with
+// the Barrett reciprocals used by the channel arithmetic and the product tree and
+// CRT inverses used for reconstruction
+struct RnsBasis
+{
+    std::vector<uint32_t> moduli;
+    std::vector<uint64_t> reciprocals; // floor((2^64 - 1) / m_i)
+    std::vector<uint32_t> inverses;    // (M / m_i)^-1 mod m_i
+    std::vector<BigInt> tree;          // subtree products, node 0 = M, children 2i + 1 and 2i + 2
+    BigInt half_modulus;               // M / 2, values live in (-M/2, M/2]
+
+    explicit RnsBasis(size_t count)
+    {
+        if (count == 0)
+            throw std::invalid_argument("RnsBasis: no moduli");
+        for (uint32_t p = 0x7FFFFFFFu; moduli.size() < count; p -= 2)
+        {
+            if (limb_ops::is_prime_u32(p))
+                moduli.push_back(p);
+        }
+        for (uint32_t m : moduli)
+            reciprocals.push_back(UINT64_MAX / m);
+        tree.resize(4 * count);
+        build(0, 0, count);
+        half_modulus = tree[0] >> 1;
+        // (M / m_i) mod m_i = (M mod m_i^2) / m_i
+        std::vector<BigInt> squares;
+        for (uint32_t m : moduli)
+            squares.emplace_back(uint64_t(m) * m);
+        std::vector<BigInt> reduced = BigInt::remainder_tree(tree[0], squares);
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint64_t r = 0;
+            for (size_t j = reduced[i].digits.size(); j-- > 0;)
+                r = (r << 32) | reduced[i].digits[j];
+            uint32_t cofactor = static_cast<uint32_t>(r / moduli[i]);
+            inverses.push_back(limb_ops::powmod_u32(cofactor, moduli[i] - 2, moduli[i]));
+        }
+    }
+
+    // Enough moduli to represent every value of magnitude below 2^bits
+    static std::shared_ptr<const RnsBasis> for_bits(size_t bits)
+    {
+        return std::make_shared<const RnsBasis>((bits + 1) / 30 + 1);
+    }
+
+    const BigInt &modulus() const
+    {
+        return tree[0];
+    }
+
+    // Residues of x modulo every m_i in one pass over its limbs
+    std::vector<uint32_t> reduce(const BigInt &x) const
+    {
+        size_t count = moduli.size();
+        std::vector<uint32_t> r(count);
+        for (size_t i = x.digits.size(); i-- > 0;)
+        {
+            uint32_t limb = x.digits[i];
+            for (size_t j = 0; j < count; ++j)
+                r[j] = limb_ops::barrett_reduce((uint64_t(r[j]) << 32) | limb, moduli[j], reciprocals[j]);
+        }
+        if (x.negative)
+        {
+            for (size_t j = 0; j < count; ++j)
+                r[j] = r[j] ? moduli[j] - r[j] : 0;
+        }
+        return r;
+    }
+
+    // CRT: x = sum_i c_i * M / m_i mod M with c_i = r_i * inverses[i] mod m_i. The sum
+    // is formed up the product tree as V = V_left * P_right + V_right * P_left.
+    BigInt reconstruct(const std::vector<uint32_t> &residues) const
+    {
+        size_t count = moduli.size();
+        std::vector<uint32_t> c(count);
+        for (size_t i = 0; i < count; ++i)
+            c[i] = limb_ops::barrett_reduce(uint64_t(residues[i]) * inverses[i], moduli[i], reciprocals[i]);
+        BigInt x = combine(c.data(), 0, count) % modulus();
+        if (half_modulus < x)
+            x = x - modulus();
+        return x;
+    }
+
+private:
+    void build(size_t node, size_t lo, size_t hi)
+    {
+        if (hi - lo == 1)
+        {
+            tree[node] = BigInt(moduli[lo]);
+            return;
+        }
+        size_t mid = lo + (hi - lo) / 2;
+        build(2 * node + 1, lo, mid);
+        build(2 * node + 2, mid, hi);
+        tree[node] = tree[2 * node + 1] * tree[2 * node + 2];
+    }
+
+    BigInt combine(const uint32_t *c, size_t node, size_t count) const
+    {
+        if (count == 1)
+            return BigInt(c[0]);
+        size_t mid = count / 2;
+        return combine(c, 2 * node + 1, mid) * tree[2 * node + 2] +
+               combine(c + mid, 2 * node + 2, count - mid) * tree[2 * node + 1];
+    }
+};
+
+// A BigInt held as its residues modulo the primes of an RnsBasis. Addition,
+// subtraction and multiplication work channel by channel on words with no carries
+// between channels; to_bigint reconstructs the value by CRT, exactly as long as every
+// intermediate stays within (-M/2, M/2].
+struct RnsInt
+{
+    std::shared_ptr<const RnsBasis> basis;
+    std::vector<uint32_t> residues;
+
+    RnsInt(const BigInt &value, std::shared_ptr<const RnsBasis> rns_basis)
+        : basis(std::move(rns_basis)), residues(basis->reduce(value))
+    {
+    }
+
+    BigInt to_bigint() const
+    {
+        return basis->reconstruct(residues);
+    }
+
+    RnsInt operator+(const RnsInt &other) const
+    {
+        return zip(other, [](uint32_t a, uint32_t b, uint32_t m, uint64_t) {
+            uint32_t s = a + b;
+            return s >= m ? s - m : s;
+        });
+    }
+
+    RnsInt operator-(const RnsInt &other) const
+    {
+        return zip(other, [](uint32_t a, uint32_t b, uint32_t m, uint64_t) { return a >= b ? a - b : a + (m - b); });
+    }
+
+    RnsInt operator*(const RnsInt &other) const
+    {
+        return zip(other, [](uint32_t a, uint32_t b, uint32_t m, uint64_t reciprocal) {
+            return limb_ops::barrett_reduce(uint64_t(a) * b, m, reciprocal);
+        });
+    }
+
+    RnsInt operator-() const
+    {
+        RnsInt result = *this;
+        for (size_t i = 0; i < residues.size(); ++i)
+            result.residues[i] = residues[i] ? basis->moduli[i] - residues[i] : 0;
+        return result;
+    }
+
+    bool operator==(const RnsInt &other) const
+    {
+        return basis == other.basis && residues == other.residues;
+    }
+
+private:
+    template <typename Op>
+    RnsInt zip(const RnsInt &other, Op op) const
+    {
+        if (basis != other.basis)
+            throw std::invalid_argument("RnsInt: operands use different bases");
+        RnsInt result = *this;
+        const uint32_t *m = basis->moduli.data();
+        const uint64_t *reciprocal = basis->reciprocals.data();
+        for (size_t i = 0; i < residues.size(); ++i)
+            result.residues[i] = op(residues[i], other.residues[i], m[i], reciprocal[i]);
+        return result;
+    }
+};
+
+#ifdef BIGINT_BENCH
+#include <chrono>
+#include <functional>
+#include <sstream>
+
+// Times fn over `reps` calls and returns nanoseconds per call
+template <typename F>
+static double bench_ns(F fn, int reps)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < reps; ++i)
+        fn();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / reps;
+}
+
+// Scalar schoolbook versus the IFMA kernel around the operator* base-case range
+static void bench_mul_kernels()
+{
+    std::mt19937 rng(12345);
+    std::cout << "ifma available: " << (limb_ops::cpu_has_ifma() ? "yes" : "no") << '\n';
+    std::cout << std::setw(6) << "limbs" << std::setw(14) << "mul scalar" << std::setw(14) << "mul ifma"
+              << std::setw(14) << "sqr scalar" << std::setw(14) << "sqr ifma" << "   (ns/op)\n";
+    for (size_t n : {8, 12, 16, 24, 32, 48, 64})
+    {
+        std::vector<uint32_t> a(n), b(n), r(2 * n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            a[i] = rng();
+            b[i] = rng();
+        }
+        int reps = static_cast<int>(4000000 / (n * n)) + 1000;
+        std::cout << std::setw(6) << n << std::fixed << std::setprecision(1);
+        std::cout << std::setw(14) << bench_ns([&] { limb_ops::mul_basecase(r.data(), a.data(), n, b.data(), n); }, reps);
+#ifdef BIGINT_X86_SIMD
+        if (limb_ops::cpu_has_ifma())
+            std::cout << std::setw(14) << bench_ns([&] { limb_ops::mul_ifma(r.data(), a.data(), n, b.data(), n); }, reps);
+        else
+#endif
+            std::cout << std::setw(14) << "-";
+        std::cout << std::setw(14) << bench_ns([&] { limb_ops::sqr_basecase(r.data(), a.data(), n); }, reps);
+#ifdef BIGINT_X86_SIMD
+        if (limb_ops::cpu_has_ifma())
+            std::cout << std::setw(14) << bench_ns([&] { limb_ops::sqr_ifma(r.data(), a.data(), n); }, reps);
+        else
+#endif
+            std::cout << std::setw(14) << "-";
+        std::cout << '\n';
+    }
+}
+
+// Base case versus the Karatsuba dispatcher above the crossover
+static void bench_karatsuba()
+{
+    std::mt19937 rng(12345);
+    std::cout << std::setw(6) << "limbs" << std::setw(14) << "mul base" << std::setw(14) << "mul"
+              << std::setw(14) << "sqr base" << std::setw(14) << "sqr" << "   (ns/op)\n";
+    for (size_t n : {48, 64, 96, 128, 256, 512, 1024})
+    {
+        std::vector<uint32_t> a(n), b(n), r(2 * n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            a[i] = rng();
+            b[i] = rng();
+        }
+        int reps = static_cast<int>(40000000 / (n * n)) + 20;
+        std::cout << std::setw(6) << n << std::fixed << std::setprecision(1);
+        std::cout << std::setw(14) << bench_ns([&] { limb_ops::mul_base(r.data(), a.data(), n, b.data(), n); }, reps);
+        std::cout << std::setw(14) << bench_ns([&] { limb_ops::mul(r.data(), a.data(), n, b.data(), n); }, reps);
+        std::cout << std::setw(14) << bench_ns([&] { limb_ops::sqr_base(r.data(), a.data(), n); }, reps);
+        std::cout << std::setw(14) << bench_ns([&] { limb_ops::sqr(r.data(), a.data(), n); }, reps);
+        std::cout << '\n';
+    }
+}
+
+// std::allocator that counts calls to allocate, to see how many buffers an expression creates
+template <typename T>
+struct CountingAllocator : std::allocator<T>
+{
+    static inline size_t allocations = 0;
+
+    CountingAllocator() = default;
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U> &) {}
+
+    T *allocate(size_t n)
+    {
+        ++allocations;
+        return std::allocator<T>::allocate(n);
+    }
+};
+
+// Heap allocations per evaluation of typical expressions, with every intermediate bound
+// to a name (const operators only) versus written inline (rvalue overloads)
+static void bench_rvalue_allocs()
+{
+    using CountedInt = BasicBigInt<CountingAllocator<uint32_t>>;
+    std::mt19937 rng(12345);
+    auto random = [&](size_t limbs) {
+        CountedInt x;
+        x.digits.resize(limbs);
+        for (uint32_t &d : x.digits)
+            d = rng() | 1;
+        return x;
+    };
+    CountedInt a = random(40), b = random(40), c = random(40), d = random(20);
+    auto count = [](auto fn) {
+        size_t before = CountingAllocator<uint32_t>::allocations;
+        fn();
+        return CountingAllocator<uint32_t>::allocations - before;
+    };
+    std::cout << std::left << std::setw(26) << "expression" << std::right << std::setw(10) << "named"
+              << std::setw(10) << "inline" << "   (allocations)\n";
+    auto row = [&](const char *name, auto named, auto inline_) {
+        std::cout << std::left << std::setw(26) << name << std::right << std::setw(10) << count(named)
+                  << std::setw(10) << count(inline_) << '\n';
+    };
+    row(
+        "a + b + c + d",
+        [&] {
+            CountedInt t1 = a + b;
+            CountedInt t2 = t1 + c;
+            CountedInt r = t2 + d;
+        },
+        [&] { CountedInt r = a + b + c + d; });
+    row(
+        "(a - b) * c + d",
+        [&] {
+            CountedInt t1 = a - b;
+            CountedInt t2 = t1 * c;
+            CountedInt r = t2 + d;
+        },
+        [&] { CountedInt r = (a - b) * c + d; });
+    row(
+        "a * 10 + b * 3 - c",
+        [&] {
+            CountedInt t1 = a * 10;
+            CountedInt t2 = b * 3;
+            CountedInt t3 = t1 + t2;
+            CountedInt r = t3 - c;
+        },
+        [&] { CountedInt r = a * 10 + b * 3 - c; });
+    row(
+        "((a << 40) | b) >> 7",
+        [&] {
+            CountedInt t1 = a << 40;
+            CountedInt t2 = t1 | b;
+            CountedInt r = t2 >> 7;
+        },
+        [&] { CountedInt r = ((a << 40) | b) >> 7; });
+}
+
+// r = a*b + c*d - e through the operators versus a lazy expression, into a reused r
+static void bench_lazy()
 {
+    using CountedInt = BasicBigInt<CountingAllocator<uint32_t>>;
+    std::mt19937 rng(12345);
+    std::cout << std::setw(6) << "limbs" << std::setw(14) << "eager ns" << std::setw(14) << "lazy ns"
+              << std::setw(14) << "eager allocs" << std::setw(14) << "lazy allocs" << '\n';
+    for (size_t n : {2, 8, 32, 128, 512})
+    {
+        CountedInt v[5];
+        for (CountedInt &x : v)
+        {
+            x.digits.resize(n);
+            for (uint32_t &d : x.digits)
+                d = rng() | 1;
+        }
+        const CountedInt &a = v[0], &b = v[1], &c = v[2], &d = v[3], &e = v[4];
+        CountedInt r = a * b + c * d - e;
+        int reps = static_cast<int>(20000000 / (n * n)) + 20;
+        auto eager = [&] { r = a * b + c * d - e; };
+        auto lazy_ = [&] { r = lazy(a) * b + lazy(c) * d - e; };
+        // Counted after a warm-up call, once r has settled on a capacity
+        eager();
+        size_t before = CountingAllocator<uint32_t>::allocations;
+        eager();
+        size_t eager_allocs = CountingAllocator<uint32_t>::allocations - before;
+        lazy_();
+        before = CountingAllocator<uint32_t>::allocations;
+        lazy_();
+        size_t lazy_allocs = CountingAllocator<uint32_t>::allocations - before;
+        std::cout << std::setw(6) << n << std::fixed << std::setprecision(1) << std::setw(14) << bench_ns(eager, reps)
+                  << std::setw(14) << bench_ns(lazy_, reps) << std::setw(14) << eager_allocs << std::setw(14)
+                  << lazy_allocs << '\n';
+    }
+}
+
+// A 64-term dot product as acc = acc + x * y, as acc.addmul(x, y) and as BigInt::dot
+static void bench_dot()
+{
+    using CountedInt = BasicBigInt<CountingAllocator<uint32_t>>;
+    std::mt19937 rng(12345);
+    std::cout << std::setw(6) << "limbs" << std::setw(14) << "operators" << std::setw(14) << "addmul"
+              << std::setw(14) << "dot" << "   (ns/dot, allocations)\n";
+    for (size_t n : {1, 4, 16, 64, 256})
+    {
+        std::vector<CountedInt> x(64), y(64);
+        for (size_t i = 0; i < 64; ++i)
+        {
+            x[i].digits.resize(n);
+            y[i].digits.resize(n);
+            for (size_t j = 0; j < n; ++j)
+            {
+                x[i].digits[j] = rng() | 1;
+                y[i].digits[j] = rng() | 1;
+            }
+            x[i].negative = rng() & 1;
+        }
+        auto operators = [&] {
+            CountedInt acc;
+            for (size_t i = 0; i < 64; ++i)
+                acc = acc + x[i] * y[i];
+        };
+        auto addmul = [&] {
+            CountedInt acc;
+            for (size_t i = 0; i < 64; ++i)
+                acc.addmul(x[i], y[i]);
+        };
+        auto dot = [&] { CountedInt acc = CountedInt::dot(x, y); };
+        int reps = static_cast<int>(2000000 / (n * n)) + 20;
+        std::cout << std::setw(6) << n;
+        for (auto fn : {std::function<void()>(operators), std::function<void()>(addmul), std::function<void()>(dot)})
+        {
+            size_t before = CountingAllocator<uint32_t>::allocations;
+            fn();
+            size_t allocs = CountingAllocator<uint32_t>::allocations - before;
+            std::ostringstream cell;
+            cell << std::fixed << std::setprecision(0) << bench_ns(fn, reps) << ", " << allocs;
+            std::cout << std::setw(14) << cell.str();
+        }
+        std::cout << '\n';
+    }
+}
+
+// Decimal text versus the binary record format, both directions
+static void bench_serialize()
+{
+    std::mt19937 rng(12345);
+    std::cout << std::setw(6) << "limbs" << std::setw(14) << "to_string" << std::setw(14) << "serialize"
+              << std::setw(14) << "parse" << std::setw(14) << "deserialize" << std::setw(14) << "load"
+              << "   (ns/op)\n";
+    for (size_t n : {16, 256, 4096})
+    {
+        BigInt x;
+        x.digits.resize(n);
+        for (uint32_t &d : x.digits)
+            d = rng() | 1;
+        std::string text = x.to_string();
+        std::vector<std::byte> record(x.serialized_size());
+        int reps = static_cast<int>(20000000 / (n * n)) + 2;
+        std::cout << std::setw(6) << n << std::fixed << std::setprecision(0);
+        std::cout << std::setw(14) << bench_ns([&] { text = x.to_string(); }, reps);
+        std::cout << std::setw(14) << bench_ns([&] { x.serialize(record); }, reps);
+        std::cout << std::setw(14) << bench_ns([&] { x = BigInt(text); }, reps);
+        std::cout << std::setw(14) << bench_ns([&] { x = BigInt::deserialize(record); }, reps);
+        std::cout << std::setw(14) << bench_ns([&] { (void)BigIntView::load(record); }, reps);
+        std::cout << '\n';
+    }
+}
+
+// Payload size and ns/value of the compact batch encoding against records
+static void bench_compact()
+{
+    std::mt19937_64 rng(12345);
+    std::cout << std::setw(10) << "max bits" << std::setw(12) << "record B" << std::setw(12) << "compact B"
+              << std::setw(12) << "encode" << std::setw(12) << "decode" << "   (per value)\n";
+    for (int bits : {8, 32, 64, 256})
+    {
+        std::vector<BigInt> values(4096);
+        for (BigInt &x : values)
+        {
+            x.digits.resize((bits + 31) / 32);
+            for (uint32_t &d : x.digits)
+                d = static_cast<uint32_t>(rng());
+            if (bits < 32)
+                x.digits[0] >>= 32 - bits;
+            x.negative = rng() & 1;
+            x.trim();
+        }
+        size_t record = 0;
+        for (const BigInt &x : values)
+            record += x.serialized_size();
+        std::vector<std::byte> wire = BigInt::encode_compact_batch(values);
+        double n = static_cast<double>(values.size());
+        std::cout << std::setw(10) << bits << std::fixed << std::setprecision(1);
+        std::cout << std::setw(12) << record / n << std::setw(12) << wire.size() / n;
+        std::cout << std::setw(12) << bench_ns([&] { wire = BigInt::encode_compact_batch(values); }, 200) / n;
+        std::cout << std::setw(12) << bench_ns([&] { values = BigInt::decode_compact_batch(wire); }, 200) / n;
+        std::cout << '\n';
+    }
+}
+#endif
+
+int main()
+{
+#ifdef BIGINT_BENCH
+    bench_mul_kernels();
+    bench_karatsuba();
+    bench_rvalue_allocs();
+    bench_lazy();
+    bench_dot();
+    bench_serialize();
+    bench_compact();
+    return 0;
+#endif
     BigInt a, b;
     std::cin >> a >> b;
     std::cout << "a + b = " << a + b << '\n';
@@ -447,5 +6007,6 @@ int main()
     }
     std::cout << "a & b = " << (a & b) << '\n';
     std::cout << "a | b = " << (a | b) << '\n';
+    std::cout << "a ^ b = " << (a ^ b) << '\n';
     return 0;
 }